@@ -7,6 +7,7 @@
 #include "devices/shutdown.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/workqueue.h"
 
 /* Keyboard data register port. */
 #define DATA_REG 0x60
@@ -24,12 +25,25 @@ static bool caps_lock;
 /* Number of keys pressed. */
 static int64_t key_cnt;
 
+/* Scancodes read by the interrupt handler and not yet
+   interpreted.  Only the handler advances scan_head and only
+   decode_work advances scan_tail. */
+#define SCAN_BUF_SIZE 64
+static unsigned scan_buf[SCAN_BUF_SIZE];
+static unsigned scan_head, scan_tail;
+
+/* Interprets the scancodes in scan_buf. */
+static struct work decode_work;
+
 static intr_handler_func keyboard_interrupt;
+static work_func decode_scancodes;
+static void decode_scancode (unsigned code);
 
 /* Initializes the keyboard. */
 void
 kbd_init (void) 
 {
+  work_init (&decode_work, decode_scancodes, NULL);
   intr_register_ext (0x21, keyboard_interrupt, "8042 Keyboard");
 }
 
@@ -92,27 +106,69 @@ static const struct keymap shifted_keymap[] =
 
 static bool map_key (const struct keymap[], unsigned scancode, uint8_t *);
 
+/* Keyboard interrupt handler.  Reads the scancode and leaves
+   interpreting it to decode_scancodes(). */
 static void
 keyboard_interrupt (struct intr_frame *args UNUSED) 
+{
+  /* Keyboard scancode. */
+  unsigned code;
+
+  /* Read scancode, including second byte if prefix code. */
+  code = inb (DATA_REG);
+  if (code == 0xe0)
+    code = (code << 8) | inb (DATA_REG);
+
+  /* Drop the key if the buffer is full. */
+  if (scan_head - scan_tail < SCAN_BUF_SIZE)
+    {
+      scan_buf[scan_head % SCAN_BUF_SIZE] = code;
+      scan_head++;
+      intr_defer (&decode_work);
+    }
+}
+
+/* Interprets the scancodes that the interrupt handler has read.
+   Runs in the softirq thread. */
+static void
+decode_scancodes (void *aux UNUSED)
+{
+  for (;;)
+    {
+      enum intr_level old_level;
+      unsigned code;
+
+      old_level = intr_disable ();
+      if (scan_tail == scan_head)
+        {
+          intr_set_level (old_level);
+          break;
+        }
+      code = scan_buf[scan_tail % SCAN_BUF_SIZE];
+      scan_tail++;
+      intr_set_level (old_level);
+
+      decode_scancode (code);
+    }
+}
+
+/* Interprets scancode CODE, updating the shift state or adding a
+   character to the input buffer. */
+static void
+decode_scancode (unsigned code)
 {
   /* Status of shift keys. */
   bool shift = left_shift || right_shift;
   bool alt = left_alt || right_alt;
   bool ctrl = left_ctrl || right_ctrl;
 
-  /* Keyboard scancode. */
-  unsigned code;
-
   /* False if key pressed, true if key released. */
   bool release;
 
   /* Character that corresponds to `code'. */
   uint8_t c;
 
-  /* Read scancode, including second byte if prefix code. */
-  code = inb (DATA_REG);
-  if (code == 0xe0)
-    code = (code << 8) | inb (DATA_REG);
+  enum intr_level old_level;
 
   /* Bit 0x80 distinguishes key press from key release
      (even if there's a prefix). */
@@ -154,11 +210,13 @@ keyboard_interrupt (struct intr_frame *args UNUSED)
             c += 0x80;
 
           /* Append to keyboard buffer. */
+          old_level = intr_disable ();
           if (!input_full ())
             {
               key_cnt++;
               input_putc (c);
             }
+          intr_set_level (old_level);
         }
     }
   else
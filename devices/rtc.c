@@ -1,5 +1,7 @@
 #include "devices/rtc.h"
+#include <debug.h>
 #include <stdio.h>
+#include "threads/interrupt.h"
 #include "threads/io.h"
 
 /* This code is an interface to the MC146818A-compatible real
@@ -29,13 +31,21 @@
 /* Register A. */
 #define RTCSA_UIP	0x80	/* Set while time update in progress. */
 
+#define RTCSA_RATE	0x0f	/* Periodic interrupt rate select. */
+
 /* Register B. */
 #define	RTCSB_SET	0x80	/* Disables update to let time be set. */
+#define RTCSB_PIE	0x40	/* 1 = periodic interrupt enabled. */
 #define RTCSB_DM	0x04	/* 0 = BCD time format, 1 = binary format. */
 #define RTCSB_24HR	0x02    /* 0 = 12-hour format, 1 = 24-hour format. */
 
+/* Rate select for RTC_PERIODIC_HZ: the periodic interrupt runs
+   at 32768 >> (rate - 1) Hz. */
+#define RTC_PERIODIC_RATE 3
+
 static int bcd_to_bin (uint8_t);
 static uint8_t cmos_read (uint8_t index);
+static void cmos_write (uint8_t index, uint8_t data);
 
 /* Returns number of seconds since Unix epoch of January 1,
    1970. */
@@ -95,6 +105,37 @@ rtc_get_time (void)
   return time;
 }
 
+/* Starts the periodic interrupt, IRQ 8, at RTC_PERIODIC_HZ.
+   Interrupts must be off. */
+void
+rtc_periodic_start (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  cmos_write (RTC_REG_A, ((cmos_read (RTC_REG_A) & ~RTCSA_RATE)
+                          | RTC_PERIODIC_RATE));
+  cmos_write (RTC_REG_B, cmos_read (RTC_REG_B) | RTCSB_PIE);
+  rtc_periodic_ack ();
+}
+
+/* Stops the periodic interrupt.  Interrupts must be off. */
+void
+rtc_periodic_stop (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  cmos_write (RTC_REG_B, cmos_read (RTC_REG_B) & ~RTCSB_PIE);
+  rtc_periodic_ack ();
+}
+
+/* Acknowledges a periodic interrupt.  The RTC raises no further
+   interrupts until this is done. */
+void
+rtc_periodic_ack (void)
+{
+  cmos_read (RTC_REG_C);
+}
+
 /* Returns the integer value of the given BCD byte. */
 static int
 bcd_to_bin (uint8_t x)
@@ -110,3 +151,11 @@ cmos_read (uint8_t index)
   outb (CMOS_REG_SET, index);
   return inb (CMOS_REG_IO);
 }
+
+/* Writes DATA to the CMOS register with the given INDEX. */
+static void
+cmos_write (uint8_t index, uint8_t data)
+{
+  outb (CMOS_REG_SET, index);
+  outb (CMOS_REG_IO, data);
+}
@@ -5,4 +5,11 @@ typedef unsigned long time_t;
 
 time_t rtc_get_time (void);
 
+/* Frequency of the periodic interrupt. */
+#define RTC_PERIODIC_HZ 8192
+
+void rtc_periodic_start (void);
+void rtc_periodic_stop (void);
+void rtc_periodic_ack (void);
+
 #endif
@@ -1,12 +1,16 @@
 #include "devices/timer.h"
 #include <debug.h>
+#include <heap.h>
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
 #include "devices/pit.h"
+#include "devices/rtc.h"
 #include "threads/interrupt.h"
+#include "threads/seqcount.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
   
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -17,14 +21,75 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
-/* Number of timer ticks since OS booted. */
+/* Number of timer ticks since OS booted, and the sequence
+   counter that lets timer_ticks() read it without turning
+   interrupts off. */
 static int64_t ticks;
+static struct seqcount ticks_seq;
+
+/* PIT cycles in one timer tick. */
+#define TICK_CYCLES ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* If false (default), the timer interrupts TIMER_FREQ times per
+   second no matter what.
+   If true, the idle thread stops the periodic tick and programs
+   a single interrupt for the next sleeping thread's wakeup.
+   Controlled by kernel command-line option "-nohz". */
+bool timer_nohz;
+
+/* While the periodic tick is stopped, the number of ticks that
+   will have elapsed when the one-shot interrupt arrives and the
+   PIT count it was started with.  ONESHOT_TICKS is 0 while the
+   tick is running normally. */
+static int64_t oneshot_ticks;
+static uint16_t oneshot_count;
+
+/* Wakes up sleeping threads that are due, outside the timer
+   interrupt. */
+static struct work wake_work;
+
+/* Nanoseconds per second and per timer tick. */
+#define NSEC_PER_SEC 1000000000
+#define TICK_NS (NSEC_PER_SEC / TIMER_FREQ)
+
+/* Number of timer ticks over which the TSC is calibrated. */
+#define TSC_CALIBRATE_TICKS 8
+
+/* Time-stamp counter frequency in Hz, or 0 until
+   timer_calibrate() has measured it.  timer_ns() counts from
+   TSC_BASE, which was read NS_BASE nanoseconds after boot. */
+static uint64_t tsc_hz;
+static uint64_t tsc_base;
+static int64_t ns_base;
+
+/* A thread blocked in a high-resolution sleep. */
+struct hrtimer_sleeper
+  {
+    struct heap_elem elem;      /* Element in hrtimer_heap. */
+    int64_t expires;            /* timer_ns() value to wake up at. */
+    struct thread *thread;      /* Sleeping thread. */
+  };
+
+/* Threads in high-resolution sleeps, soonest expiry first.
+   While it is nonempty, the RTC periodic interrupt checks it
+   RTC_PERIODIC_HZ times per second. */
+static struct heap hrtimer_heap;
+
+/* Sleeps with less than this many nanoseconds to go spin on the
+   TSC instead of blocking, because the RTC interrupt cannot
+   time them more finely. */
+#define HRTIMER_SPIN_NS (2 * (NSEC_PER_SEC / RTC_PERIODIC_HZ))
 
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
 static intr_handler_func timer_interrupt;
+static intr_handler_func hrtimer_interrupt;
+static work_func wake_sleepers;
+static heap_less_func expires_less;
+static void calibrate_tsc (void);
+static void hrtimer_sleep_until (int64_t deadline);
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
@@ -37,9 +102,15 @@ timer_init (void)
 {
   pit_configure_channel (0, 2, TIMER_FREQ);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+  seqcount_init (&ticks_seq);
+  work_init (&wake_work, wake_sleepers, NULL);
+  heap_init (&hrtimer_heap, expires_less, NULL);
+  intr_register_ext (0x28, hrtimer_interrupt, "RTC Periodic");
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates loops_per_tick, used to implement brief delays, and
+   the TSC frequency, used by timer_ns() and high-resolution
+   sleeps. */
 void
 timer_calibrate (void) 
 {
@@ -64,18 +135,45 @@ timer_calibrate (void)
       loops_per_tick |= test_bit;
 
   printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+
+  calibrate_tsc ();
+  printf ("TSC runs at %'"PRIu64" kHz.\n", tsc_hz / 1000);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
 int64_t
 timer_ticks (void) 
 {
-  enum intr_level old_level = intr_disable ();
-  int64_t t = ticks;
-  intr_set_level (old_level);
+  unsigned seq;
+  int64_t t;
+
+  do
+    {
+      seq = seqcount_read_begin (&ticks_seq);
+      t = ticks;
+    }
+  while (seqcount_read_retry (&ticks_seq, seq));
   return t;
 }
 
+/* Returns the number of nanoseconds since the OS booted, from a
+   clock that never goes backward.  Until timer_calibrate() has
+   run, the clock advances only once per timer tick. */
+int64_t
+timer_ns (void)
+{
+  uint64_t delta;
+
+  if (tsc_hz == 0)
+    return timer_ticks () * TICK_NS;
+
+  /* Split DELTA into whole seconds and a remainder to avoid
+     overflow in the conversion. */
+  delta = rdtsc () - tsc_base;
+  return (ns_base + delta / tsc_hz * NSEC_PER_SEC
+          + delta % tsc_hz * NSEC_PER_SEC / tsc_hz);
+}
+
 /* Returns the number of timer ticks elapsed since THEN, which
    should be a value once returned by timer_ticks(). */
 int64_t
@@ -96,7 +194,7 @@ timer_sleep (int64_t ticks)
   //  thread_yield ();
 }
 
-/* Sleeps for approximately MS milliseconds.  Interrupts must be
+/* Sleeps for at least MS milliseconds.  Interrupts must be
    turned on. */
 void
 timer_msleep (int64_t ms) 
@@ -104,7 +202,7 @@ timer_msleep (int64_t ms)
   real_time_sleep (ms, 1000);
 }
 
-/* Sleeps for approximately US microseconds.  Interrupts must be
+/* Sleeps for at least US microseconds.  Interrupts must be
    turned on. */
 void
 timer_usleep (int64_t us) 
@@ -112,7 +210,7 @@ timer_usleep (int64_t us)
   real_time_sleep (us, 1000 * 1000);
 }
 
-/* Sleeps for approximately NS nanoseconds.  Interrupts must be
+/* Sleeps for at least NS nanoseconds.  Interrupts must be
    turned on. */
 void
 timer_nsleep (int64_t ns) 
@@ -166,23 +264,225 @@ timer_print_stats (void)
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
 }
 
+/* Called by the idle thread, with interrupts off, just before
+   it halts the CPU.  In -nohz mode, if no thread needs to wake
+   up at the next tick, replaces the periodic tick by a single
+   interrupt at the earliest wakeup tick (or as far ahead as the
+   PIT's 16-bit counter allows).  The one-shot is started so
+   that it expires exactly on a tick boundary, which keeps the
+   phase of the periodic tick.
+
+   The MLFQS scheduler samples the system every tick and every
+   second, so the tick is never stopped when it is in use. */
+void
+timer_idle_enter (void)
+{
+  int64_t delta;
+  uint16_t left;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_nohz || thread_mlfqs || oneshot_ticks != 0)
+    return;
+
+  delta = thread_next_wakeup () - ticks;
+  if (delta <= 1)
+    return;
+
+  /* LEFT cycles remain before the next periodic tick.  Each
+     tick after that adds TICK_CYCLES. */
+  left = pit_read_back (0, NULL);
+  if (left == 0 || left > TICK_CYCLES)
+    return;
+  if (delta - 1 > (UINT16_MAX - left) / TICK_CYCLES)
+    delta = (UINT16_MAX - left) / TICK_CYCLES + 1;
+  if (delta <= 1)
+    return;
+
+  oneshot_ticks = delta;
+  oneshot_count = left + (delta - 1) * TICK_CYCLES;
+  pit_start_oneshot (0, oneshot_count);
+}
+
+/* Called with interrupts off when the idle thread stops
+   running.  If the periodic tick is stopped and the one-shot has
+   not expired yet, which happens when some other interrupt made
+   a thread ready, accounts for the whole ticks that have passed
+   since it was started and restarts the tick.  The partial tick
+   in progress is finished with one more one-shot, so that the
+   periodic tick keeps its phase. */
+void
+timer_idle_exit (void)
+{
+  unsigned elapsed, whole;
+  uint16_t left;
+  bool expired;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (oneshot_ticks == 0)
+    return;
+
+  /* If the one-shot has expired, its interrupt is pending and
+     timer_interrupt() will do the accounting as soon as
+     interrupts are turned back on. */
+  left = pit_read_back (0, &expired);
+  if (expired || left > oneshot_count)
+    return;
+
+  elapsed = oneshot_count - left;
+  whole = elapsed / TICK_CYCLES;
+  seqcount_write_begin (&ticks_seq);
+  ticks += whole;
+  seqcount_write_end (&ticks_seq);
+  oneshot_ticks = 1;
+  oneshot_count = TICK_CYCLES - elapsed % TICK_CYCLES;
+  pit_start_oneshot (0, oneshot_count);
+}
+
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
-  ticks++;
-  if (thread_mlfqs){
-    increase_recent_cpu();
-    if (timer_ticks() % 4 == 0){
-      update_priority();
-    }
-    if (timer_ticks() % TIMER_FREQ == 0){
-      update_recent_cpu();
-      calc_load_avg();
+  seqcount_write_begin (&ticks_seq);
+  if (oneshot_ticks != 0)
+    {
+      /* The one-shot expired on a tick boundary.  Account for
+         the ticks that it skipped and restart the periodic
+         tick. */
+      ticks += oneshot_ticks - 1;
+      oneshot_ticks = 0;
+      pit_configure_channel (0, 2, TIMER_FREQ);
     }
-  }
+  ticks++;
+  seqcount_write_end (&ticks_seq);
+  if (thread_mlfqs)
+    thread_mlfqs_tick (ticks);
   thread_tick ();
+
+  /* Leave waking sleepers to the softirq thread, but only bother
+     it when one is due.  The softirq thread does not run ahead of
+     a real-time thread, so while one is running, wake them here
+     instead. */
+  if (thread_next_wakeup () <= ticks)
+    {
+      if (thread_is_rt (thread_current ()))
+        {
+          thread_wake (ticks);
+          thread_preempt ();
+        }
+      else
+        intr_defer (&wake_work);
+    }
+}
+
+/* Wakes up the sleeping threads that are due.  Runs in the
+   softirq thread. */
+static void
+wake_sleepers (void *aux UNUSED)
+{
+  enum intr_level old_level = intr_disable ();
   thread_wake (ticks);
+  intr_set_level (old_level);
+}
+
+/* RTC periodic interrupt handler.  Wakes up the threads whose
+   high-resolution sleeps have expired, and stops the interrupt
+   once no sleeps are left. */
+static void
+hrtimer_interrupt (struct intr_frame *args UNUSED)
+{
+  int64_t now = timer_ns ();
+  bool woken = false;
+
+  rtc_periodic_ack ();
+  while (!heap_empty (&hrtimer_heap))
+    {
+      struct hrtimer_sleeper *s = heap_entry (heap_top (&hrtimer_heap),
+                                              struct hrtimer_sleeper, elem);
+      if (s->expires > now)
+        break;
+      heap_pop (&hrtimer_heap);
+      thread_unblock (s->thread);
+      woken = true;
+    }
+  if (heap_empty (&hrtimer_heap))
+    rtc_periodic_stop ();
+  if (woken)
+    thread_preempt ();
+}
+
+/* Orders high-resolution sleepers by expiry. */
+static bool
+expires_less (const struct heap_elem *a_, const struct heap_elem *b_,
+              void *aux UNUSED)
+{
+  const struct hrtimer_sleeper *a
+    = heap_entry (a_, struct hrtimer_sleeper, elem);
+  const struct hrtimer_sleeper *b
+    = heap_entry (b_, struct hrtimer_sleeper, elem);
+
+  return a->expires < b->expires;
+}
+
+/* Measures the TSC frequency by counting TSC cycles across
+   TSC_CALIBRATE_TICKS timer ticks. */
+static void
+calibrate_tsc (void)
+{
+  int64_t start;
+  uint64_t tsc;
+
+  /* Start counting right at a tick boundary. */
+  start = ticks;
+  while (ticks == start)
+    barrier ();
+  start = ticks;
+  tsc = rdtsc ();
+
+  while (ticks - start < TSC_CALIBRATE_TICKS)
+    barrier ();
+
+  tsc_base = tsc;
+  ns_base = start * TICK_NS;
+  tsc_hz = (rdtsc () - tsc) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+}
+
+/* Sleeps until timer_ns() reaches DEADLINE.  Whole ticks are
+   slept with timer_sleep().  The remainder blocks until the RTC
+   periodic interrupt finds it expired, or spins if it is too
+   short for the interrupt to time.  Interrupts must be on. */
+static void
+hrtimer_sleep_until (int64_t deadline)
+{
+  struct hrtimer_sleeper s;
+  enum intr_level old_level;
+  int64_t left = deadline - timer_ns ();
+
+  /* timer_sleep(N) returns no more than N ticks from now. */
+  if (left >= TICK_NS)
+    {
+      timer_sleep (left / TICK_NS);
+      left = deadline - timer_ns ();
+    }
+  if (left <= 0)
+    return;
+
+  if (left < HRTIMER_SPIN_NS)
+    {
+      while (timer_ns () < deadline)
+        barrier ();
+      return;
+    }
+
+  s.expires = deadline;
+  s.thread = thread_current ();
+  old_level = intr_disable ();
+  if (heap_empty (&hrtimer_heap))
+    rtc_periodic_start ();
+  heap_push (&hrtimer_heap, &s.elem);
+  thread_block ();
+  intr_set_level (old_level);
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -218,7 +518,7 @@ busy_wait (int64_t loops)
     barrier ();
 }
 
-/* Sleep for approximately NUM/DENOM seconds. */
+/* Sleep for at least NUM/DENOM seconds. */
 static void
 real_time_sleep (int64_t num, int32_t denom) 
 {
@@ -231,7 +531,14 @@ real_time_sleep (int64_t num, int32_t denom)
   int64_t ticks = num * TIMER_FREQ / denom;
 
   ASSERT (intr_get_level () == INTR_ON);
-  if (ticks > 0)
+  if (tsc_hz != 0)
+    {
+      /* Sleep until the exact deadline, blocking even for most
+         sub-tick intervals. */
+      ASSERT (NSEC_PER_SEC % denom == 0);
+      hrtimer_sleep_until (timer_ns () + num * (NSEC_PER_SEC / denom));
+    }
+  else if (ticks > 0)
     {
       /* We're waiting for at least one full timer tick.  Use
          timer_sleep() because it will yield the CPU to other
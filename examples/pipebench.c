@@ -0,0 +1,99 @@
+/* pipebench.c
+
+   Measures pipe throughput.  Creates a pipe, starts a copy of
+   itself that reads from it until end of file, and writes the
+   given number of kilobytes (default 1024) into it in chunks of
+   the given size (default 16384 bytes).  Prints the elapsed time
+   in CPU cycles.
+
+   Large chunks let the kernel copy straight from the writer's
+   buffer into the reader's; small ones go through the pipe's
+   ring buffer. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+
+#define MAX_CHUNK 65536
+
+static char buf[MAX_CHUNK];
+
+/* Returns the processor's time-stamp counter. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Reads from RFD until end of file, in chunks of CHUNK bytes,
+   and exits with the number of kilobytes read. */
+static int
+reader (int rfd, int wfd, int chunk)
+{
+  int total = 0;
+  int n;
+
+  close (wfd);
+  while ((n = read (rfd, buf, chunk)) > 0)
+    total += n;
+  return total / 1024;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int kb = 1024, chunk = 16384;
+  int fds[2];
+  char cmd[64];
+  uint64_t start, cycles;
+  pid_t pid;
+  int left, got;
+
+  if (argc == 5 && !strcmp (argv[1], "-r"))
+    return reader (atoi (argv[2]), atoi (argv[3]), atoi (argv[4]));
+
+  if (argc > 1)
+    kb = atoi (argv[1]);
+  if (argc > 2)
+    chunk = atoi (argv[2]);
+  if (kb <= 0 || chunk <= 0 || chunk > MAX_CHUNK)
+    {
+      printf ("usage: pipebench [KB [CHUNK]]\n");
+      return EXIT_FAILURE;
+    }
+
+  if (!pipe (fds))
+    {
+      printf ("pipebench: pipe failed\n");
+      return EXIT_FAILURE;
+    }
+  snprintf (cmd, sizeof cmd, "pipebench -r %d %d %d", fds[0], fds[1], chunk);
+  memset (buf, 'x', sizeof buf);
+
+  start = rdtsc ();
+  pid = exec (cmd);
+  if (pid == PID_ERROR)
+    {
+      printf ("pipebench: exec failed\n");
+      return EXIT_FAILURE;
+    }
+  close (fds[0]);
+  for (left = kb * 1024; left > 0; left -= chunk)
+    if (write (fds[1], buf, left < chunk ? left : chunk) <= 0)
+      {
+        printf ("pipebench: write failed\n");
+        return EXIT_FAILURE;
+      }
+  close (fds[1]);
+  got = wait (pid);
+  cycles = rdtsc () - start;
+
+  printf ("pipebench: %d kB in %d-byte chunks, %d kB received, "
+          "%llu cycles (%llu cycles/kB)\n",
+          kb, chunk, got, cycles, cycles / kb);
+  return got == kb ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,40 @@
+/* schedstat.c
+
+   Prints the scheduler statistics of the processes named on the
+   command line, or of itself if none are given. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include <stdlib.h>
+
+static void
+print_schedstat (pid_t pid)
+{
+  struct schedstat st;
+
+  if (!schedstat (pid, &st))
+    {
+      printf ("%d: no such process\n", pid);
+      return;
+    }
+  printf ("%d: %lld run ticks, %lld wait ticks, "
+          "%u voluntary and %u involuntary switches, "
+          "%u wakeups (%lld ticks max latency), "
+          "%lld ticks max overrun\n",
+          pid, st.run_ticks, st.wait_ticks,
+          (unsigned) st.voluntary_cnt, (unsigned) st.involuntary_cnt,
+          (unsigned) st.wakeup_cnt, st.wakeup_max, st.overrun_max);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int i;
+
+  if (argc < 2)
+    print_schedstat (0);
+  for (i = 1; i < argc; i++)
+    print_schedstat (atoi (argv[i]));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,58 @@
+/* sysbench.c
+
+   Measures the round-trip cost of a trivial system call, made
+   first through SYSENTER (if the CPU supports it) and then
+   through int $0x30.  Takes the number of calls to make in each
+   round as an optional argument (default 100000) and prints the
+   average in CPU cycles. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+/* Returns the processor's time-stamp counter. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Makes CNT calls to fibonacci(0), which does no work in the
+   kernel, and returns the average cycles per call. */
+static uint64_t
+time_calls (int cnt)
+{
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    fibonacci (0);
+  return (rdtsc () - start) / cnt;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int cnt = argc > 1 ? atoi (argv[1]) : 100000;
+  bool have_sysenter = syscall_sysenter;
+
+  if (cnt <= 0)
+    {
+      printf ("usage: sysbench [COUNT]\n");
+      return EXIT_FAILURE;
+    }
+
+  if (have_sysenter)
+    printf ("sysenter: %llu cycles per call\n", time_calls (cnt));
+  else
+    printf ("sysenter: not supported\n");
+
+  syscall_sysenter = false;
+  printf ("int $0x30: %llu cycles per call\n", time_calls (cnt));
+  syscall_sysenter = have_sysenter;
+
+  return EXIT_SUCCESS;
+}
@@ -1,5 +1,8 @@
 #include "filesys/file.h"
 #include <debug.h>
+#include <iovec.h>
+#include "filesys/pipe.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
 
 
@@ -16,6 +19,7 @@ file_open (struct inode *inode)
       file->inode = inode;
       file->pos = 0;
       file->deny_write = false;
+      file->ref_cnt = 1;
       return file;
     }
   else
@@ -31,14 +35,54 @@ file_open (struct inode *inode)
 struct file *
 file_reopen (struct file *file) 
 {
+  if (file->pipe != NULL)
+    {
+      struct file *copy = calloc (1, sizeof *copy);
+      if (copy != NULL)
+        {
+          copy->pipe = file->pipe;
+          copy->pipe_writer = file->pipe_writer;
+          copy->ref_cnt = 1;
+          pipe_open (copy->pipe, copy->pipe_writer);
+        }
+      return copy;
+    }
   return file_open (inode_reopen (file->inode));
 }
 
-/* Closes FILE. */
+/* Adds a reference to FILE and returns FILE.  Each reference
+   must be dropped with file_close(). */
+struct file *
+file_ref (struct file *file)
+{
+  enum intr_level old_level = intr_disable ();
+  file->ref_cnt++;
+  intr_set_level (old_level);
+  return file;
+}
+
+/* Drops a reference to FILE, closing it once no references are
+   left. */
 void
 file_close (struct file *file) 
 {
-  if (file != NULL)
+  enum intr_level old_level;
+  int ref_cnt;
+
+  if (file == NULL)
+    return;
+  old_level = intr_disable ();
+  ref_cnt = --file->ref_cnt;
+  intr_set_level (old_level);
+  if (ref_cnt > 0)
+    return;
+
+  if (file->pipe != NULL)
+    {
+      pipe_close (file->pipe, file->pipe_writer);
+      free (file);
+    }
+  else
     {
       file_allow_write (file);
       inode_close (file->inode);
@@ -53,6 +97,13 @@ file_get_inode (struct file *file)
   return file->inode;
 }
 
+/* Returns true if FILE is one end of a pipe. */
+bool
+file_is_pipe (const struct file *file)
+{
+  return file->pipe != NULL;
+}
+
 /* Reads SIZE bytes from FILE into BUFFER,
    starting at the file's current position.
    Returns the number of bytes actually read,
@@ -61,7 +112,11 @@ file_get_inode (struct file *file)
 off_t
 file_read (struct file *file, void *buffer, off_t size) 
 {
-  off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
+  off_t bytes_read;
+
+  if (file->pipe != NULL)
+    return file->pipe_writer ? -1 : pipe_read (file->pipe, buffer, size);
+  bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
   file->pos += bytes_read;
   return bytes_read;
 }
@@ -87,7 +142,11 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs)
 off_t
 file_write (struct file *file, const void *buffer, off_t size) 
 {
-  off_t bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
+  off_t bytes_written;
+
+  if (file->pipe != NULL)
+    return file->pipe_writer ? pipe_write (file->pipe, buffer, size) : -1;
+  bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
   file->pos += bytes_written;
   return bytes_written;
 }
@@ -106,6 +165,65 @@ file_write_at (struct file *file, const void *buffer, off_t size,
   return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Reads from FILE into the IOVCNT buffers described by IOV, in
+   order, starting at the file's current position.  Returns the
+   total number of bytes read, which may be less than the total
+   size of the buffers if end of file is reached.  Advances
+   FILE's position by the number of bytes read.
+
+   A pipe fills only the first nonempty buffer, since a read from
+   a pipe returns as soon as any data is available. */
+off_t
+file_readv (struct file *file, const struct iovec *iov, int iovcnt)
+{
+  off_t bytes_read;
+  int i;
+
+  if (file->pipe != NULL)
+    {
+      if (file->pipe_writer)
+        return -1;
+      for (i = 0; i < iovcnt; i++)
+        if (iov[i].iov_len > 0)
+          return pipe_read (file->pipe, iov[i].iov_base, iov[i].iov_len);
+      return 0;
+    }
+  bytes_read = inode_readv_at (file->inode, iov, iovcnt, file->pos);
+  file->pos += bytes_read;
+  return bytes_read;
+}
+
+/* Writes the IOVCNT buffers described by IOV into FILE, in
+   order, starting at the file's current position.  Returns the
+   total number of bytes written, which may be less than the
+   total size of the buffers if end of file is reached.
+   Advances FILE's position by the number of bytes written. */
+off_t
+file_writev (struct file *file, const struct iovec *iov, int iovcnt)
+{
+  off_t bytes_written = 0;
+  int i;
+
+  if (file->pipe != NULL)
+    {
+      if (!file->pipe_writer)
+        return -1;
+      for (i = 0; i < iovcnt; i++)
+        {
+          off_t n = pipe_write (file->pipe, iov[i].iov_base, iov[i].iov_len);
+          if (n < 0)
+            return bytes_written > 0 ? bytes_written : -1;
+          bytes_written += n;
+          if (n < (off_t) iov[i].iov_len)
+            break;
+        }
+      return bytes_written;
+    }
+  bytes_written = inode_writev_at (file->inode, iov, iovcnt, file->pos);
+  file->pos += bytes_written;
+  return bytes_written;
+}
+
 /* Prevents write operations on FILE's underlying inode
    until file_allow_write() is called or FILE is closed. */
 void
@@ -138,6 +256,8 @@ off_t
 file_length (struct file *file) 
 {
   ASSERT (file != NULL);
+  if (file->pipe != NULL)
+    return -1;
   return inode_length (file->inode);
 }
 
@@ -5,25 +5,33 @@
 #include "filesys/inode.h"
 
 struct inode;
+struct iovec;
 /* An open file. */
 struct file 
   {
     struct inode *inode;        /* File's inode. */
     off_t pos;                  /* Current position. */
     bool deny_write;            /* Has file_deny_write() been called? */
+    struct pipe *pipe;          /* Pipe, if this is one end of a pipe. */
+    bool pipe_writer;           /* Write end of PIPE? */
+    int ref_cnt;                /* Number of references. */
   };
 
 /* Opening and closing files. */
 struct file *file_open (struct inode *);
 struct file *file_reopen (struct file *);
+struct file *file_ref (struct file *);
 void file_close (struct file *);
 struct inode *file_get_inode (struct file *);
+bool file_is_pipe (const struct file *);
 
 /* Reading and writing. */
 off_t file_read (struct file *, void *, off_t);
 off_t file_read_at (struct file *, void *, off_t size, off_t start);
 off_t file_write (struct file *, const void *, off_t);
 off_t file_write_at (struct file *, const void *, off_t size, off_t start);
+off_t file_readv (struct file *, const struct iovec *, int iovcnt);
+off_t file_writev (struct file *, const struct iovec *, int iovcnt);
 
 /* Preventing writes. */
 void file_deny_write (struct file *);
@@ -0,0 +1,289 @@
+/* Pipes.
+
+   A pipe is a one-page ring buffer shared by the files at its two
+   ends, one of which only reads and the other of which only
+   writes.  Readers block while the pipe is empty and writers
+   block while it is full.  A read returns as soon as any data is
+   available; a write returns only once all of its data has been
+   accepted, or once no reader is left.
+
+   When a reader finds the ring empty it posts its buffer in the
+   pipe and sleeps.  A writer that finds such a buffer copies
+   straight into it, through the kernel's mapping of the reader's
+   pages, so large transfers cross the pipe with a single copy
+   instead of going through the ring.  The reader's buffer must
+   be pinned for this to happen; any page of it that is not
+   present is filled through the ring as usual.
+
+   A pipe is freed when the last file at either end is closed.
+   A file is only closed once its last reference is dropped, and
+   pipe_read() and pipe_write() are only called through a file
+   the caller holds a reference to, so a thread sleeping on one
+   of the pipe's conditions always keeps its end open and the
+   pipe alive until it wakes up and returns. */
+
+#include "filesys/pipe.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+
+/* Ring buffer size. */
+#define PIPE_SIZE PGSIZE
+
+/* A reader waiting for data to be copied directly into its
+   buffer. */
+struct pipe_reader
+  {
+    uint32_t *pagedir;          /* Reader's page directory. */
+    uint8_t *buffer;            /* User buffer. */
+    off_t size;                 /* Size of BUFFER. */
+    off_t done;                 /* Bytes copied into BUFFER so far. */
+  };
+
+/* A pipe. */
+struct pipe
+  {
+    struct lock lock;           /* Protects all the members. */
+    struct condition readable;  /* Signaled when data arrives. */
+    struct condition writable;  /* Signaled when space frees up. */
+    uint8_t *ring;              /* Ring buffer, PIPE_SIZE bytes. */
+    size_t head;                /* Offset of first byte in RING. */
+    size_t used;                /* Number of bytes in RING. */
+    int reader_cnt;             /* Number of open read ends. */
+    int writer_cnt;             /* Number of open write ends. */
+    struct pipe_reader *reader; /* Reader waiting for a direct copy. */
+  };
+
+static off_t copy_to_reader (struct pipe_reader *, const uint8_t *, off_t);
+
+/* Creates a new pipe and stores files for its read and write
+   ends into *READP and *WRITEP.  Returns true if successful,
+   false on failure. */
+bool
+pipe_create (struct file **readp, struct file **writep)
+{
+  struct pipe *p = malloc (sizeof *p);
+  struct file *r = calloc (1, sizeof *r);
+  struct file *w = calloc (1, sizeof *w);
+  uint8_t *ring = palloc_get_page (0);
+
+  if (p == NULL || r == NULL || w == NULL || ring == NULL)
+    {
+      free (p);
+      free (r);
+      free (w);
+      palloc_free_page (ring);
+      return false;
+    }
+
+  lock_init (&p->lock);
+  cond_init (&p->readable);
+  cond_init (&p->writable);
+  p->ring = ring;
+  p->head = p->used = 0;
+  p->reader_cnt = p->writer_cnt = 1;
+  p->reader = NULL;
+
+  r->pipe = w->pipe = p;
+  r->pipe_writer = false;
+  w->pipe_writer = true;
+  r->ref_cnt = w->ref_cnt = 1;
+  *readp = r;
+  *writep = w;
+  return true;
+}
+
+/* Adds a reference to P's write end if WRITER is true, or its
+   read end otherwise. */
+void
+pipe_open (struct pipe *p, bool writer)
+{
+  lock_acquire (&p->lock);
+  if (writer)
+    p->writer_cnt++;
+  else
+    p->reader_cnt++;
+  lock_release (&p->lock);
+}
+
+/* Drops a reference to P's write end if WRITER is true, or its
+   read end otherwise, and frees P when no ends are left. */
+void
+pipe_close (struct pipe *p, bool writer)
+{
+  bool dead;
+
+  lock_acquire (&p->lock);
+  if (writer)
+    p->writer_cnt--;
+  else
+    p->reader_cnt--;
+  cond_broadcast (&p->readable, &p->lock);
+  cond_broadcast (&p->writable, &p->lock);
+  dead = p->reader_cnt == 0 && p->writer_cnt == 0;
+  lock_release (&p->lock);
+
+  if (dead)
+    {
+      palloc_free_page (p->ring);
+      free (p);
+    }
+}
+
+/* Reads up to SIZE bytes from P into BUFFER, which must be
+   pinned, blocking until at least one byte is available.  The
+   caller must hold a reference to a file at P's read end.
+   Returns the number of bytes read, which is 0 only at end of
+   file, that is, once P is empty and has no writers left. */
+off_t
+pipe_read (struct pipe *p, void *buffer_, off_t size)
+{
+  uint8_t *buffer = buffer_;
+  off_t bytes_read = 0;
+
+  if (size <= 0)
+    return 0;
+
+  lock_acquire (&p->lock);
+  ASSERT (p->reader_cnt > 0);
+  if (p->used == 0 && p->writer_cnt > 0 && p->reader == NULL)
+    {
+      /* Offer our buffer to the next writer. */
+      struct pipe_reader r;
+
+      r.pagedir = thread_current ()->pagedir;
+      r.buffer = buffer;
+      r.size = size;
+      r.done = 0;
+      p->reader = &r;
+      while (r.done == 0 && p->used == 0 && p->writer_cnt > 0)
+        cond_wait (&p->readable, &p->lock);
+      p->reader = NULL;
+      bytes_read = r.done;
+    }
+  else
+    while (p->used == 0 && p->writer_cnt > 0)
+      cond_wait (&p->readable, &p->lock);
+
+  /* Drain the ring, in at most two chunks. */
+  while (bytes_read < size && p->used > 0)
+    {
+      size_t chunk = PIPE_SIZE - p->head;
+      if (chunk > p->used)
+        chunk = p->used;
+      if (chunk > (size_t) (size - bytes_read))
+        chunk = size - bytes_read;
+      memcpy (buffer + bytes_read, p->ring + p->head, chunk);
+      p->head = (p->head + chunk) % PIPE_SIZE;
+      p->used -= chunk;
+      bytes_read += chunk;
+    }
+
+  cond_broadcast (&p->writable, &p->lock);
+  lock_release (&p->lock);
+  return bytes_read;
+}
+
+/* Writes SIZE bytes from BUFFER, which must be pinned, into P,
+   blocking until all of them have been accepted.  The caller
+   must hold a reference to a file at P's write end.  Returns the
+   number of bytes written, which is less than SIZE only if P's
+   last reader closes it first, or -1 if P had no readers at
+   all. */
+off_t
+pipe_write (struct pipe *p, const void *buffer_, off_t size)
+{
+  const uint8_t *buffer = buffer_;
+  off_t bytes_written = 0;
+
+  lock_acquire (&p->lock);
+  ASSERT (p->writer_cnt > 0);
+  while (bytes_written < size)
+    {
+      struct pipe_reader *r = p->reader;
+      size_t chunk;
+
+      if (p->reader_cnt == 0)
+        {
+          if (bytes_written == 0)
+            bytes_written = -1;
+          break;
+        }
+
+      /* Hand data straight to a waiting reader.  The ring is
+         empty if a reader is waiting, so this keeps bytes in
+         order. */
+      if (r != NULL && r->done == 0 && p->used == 0)
+        {
+          off_t n = copy_to_reader (r, buffer + bytes_written,
+                                    size - bytes_written);
+          if (n > 0)
+            {
+              r->done = n;
+              bytes_written += n;
+              cond_signal (&p->readable, &p->lock);
+              continue;
+            }
+        }
+
+      if (p->used == PIPE_SIZE)
+        {
+          cond_wait (&p->writable, &p->lock);
+          continue;
+        }
+
+      /* Fill the free space, in at most two chunks. */
+      while (bytes_written < size && p->used < PIPE_SIZE)
+        {
+          size_t tail = (p->head + p->used) % PIPE_SIZE;
+          chunk = (tail >= p->head ? PIPE_SIZE - tail
+                   : p->head - tail);
+          if (chunk > (size_t) (size - bytes_written))
+            chunk = size - bytes_written;
+          memcpy (p->ring + tail, buffer + bytes_written, chunk);
+          p->used += chunk;
+          bytes_written += chunk;
+        }
+      cond_signal (&p->readable, &p->lock);
+    }
+  lock_release (&p->lock);
+  return bytes_written;
+}
+
+/* Copies up to SIZE bytes from BUFFER into R's buffer through
+   the kernel mapping of its pages, stopping at the first page
+   that is not present.  Returns the number of bytes copied.
+   Writing through the kernel mapping does not touch the
+   reader's page table entries, so each page copied into is
+   marked accessed and dirty by hand; otherwise eviction could
+   take it for clean and discard the data. */
+static off_t
+copy_to_reader (struct pipe_reader *r, const uint8_t *buffer, off_t size)
+{
+  off_t copied = 0;
+
+  if (size > r->size)
+    size = r->size;
+  while (copied < size)
+    {
+      uint8_t *udst = r->buffer + copied;
+      uint8_t *kdst = pagedir_get_page (r->pagedir, udst);
+      off_t chunk = PGSIZE - pg_ofs (udst);
+
+      if (kdst == NULL)
+        break;
+      if (chunk > size - copied)
+        chunk = size - copied;
+      memcpy (kdst, buffer + copied, chunk);
+      pagedir_set_dirty (r->pagedir, udst, true);
+      pagedir_set_accessed (r->pagedir, udst, true);
+      copied += chunk;
+    }
+  return copied;
+}
@@ -0,0 +1,212 @@
+/* Priority queue.
+
+   See heap.h for basic information.
+
+   A pairing heap is a heap-ordered multiway tree.  Each node
+   keeps a pointer to its leftmost child, and the children of a
+   node form a doubly linked list through the `next' and `prev'
+   members.  The `prev' member of a leftmost child points to its
+   parent instead, which is what makes arbitrary removal
+   possible.  The root has null `next' and `prev'.
+
+   Two heaps are merged ("linked") by making the root with the
+   larger value the leftmost child of the other root.  Removing
+   the root leaves a list of subheaps, which is merged back into
+   one heap in two passes: first adjacent pairs are linked left
+   to right, then the resulting heaps are linked right to left.
+   This is what gives the O(lg n) amortized bound. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *link (struct heap *,
+                               struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+static void detach (struct heap_elem *);
+
+/* Initializes H as an empty heap that orders its elements using
+   LESS, given auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux)
+{
+  ASSERT (h != NULL);
+  ASSERT (less != NULL);
+
+  h->root = NULL;
+  h->elem_cnt = 0;
+  h->less = less;
+  h->aux = aux;
+}
+
+/* Inserts E into heap H. */
+void
+heap_push (struct heap *h, struct heap_elem *e)
+{
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+
+  e->child = e->next = e->prev = NULL;
+  h->root = h->root != NULL ? link (h, h->root, e) : e;
+  h->elem_cnt++;
+}
+
+/* Returns the minimum element in H, or a null pointer if H is
+   empty. */
+struct heap_elem *
+heap_top (const struct heap *h)
+{
+  ASSERT (h != NULL);
+
+  return h->root;
+}
+
+/* Removes and returns the minimum element in H, which must not
+   be empty. */
+struct heap_elem *
+heap_pop (struct heap *h)
+{
+  struct heap_elem *top;
+
+  ASSERT (h != NULL);
+  ASSERT (h->root != NULL);
+
+  top = h->root;
+  h->root = merge_pairs (h, top->child);
+  h->elem_cnt--;
+
+  top->child = NULL;
+  return top;
+}
+
+/* Removes E, which must be an element of H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e)
+{
+  struct heap_elem *subheap;
+
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+  ASSERT (h->root != NULL);
+
+  if (e == h->root)
+    {
+      heap_pop (h);
+      return;
+    }
+
+  /* Cut E, with all its descendants, out of the tree, then
+     merge its children back in. */
+  detach (e);
+  subheap = merge_pairs (h, e->child);
+  if (subheap != NULL)
+    h->root = link (h, h->root, subheap);
+  h->elem_cnt--;
+
+  e->child = NULL;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h)
+{
+  ASSERT (h != NULL);
+
+  return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+heap_empty (const struct heap *h)
+{
+  ASSERT (h != NULL);
+
+  return h->root == NULL;
+}
+
+/* Links the heaps rooted at A and B, which must both be roots
+   without siblings, and returns the root of the result. */
+static struct heap_elem *
+link (struct heap *h, struct heap_elem *a, struct heap_elem *b)
+{
+  ASSERT (a->next == NULL && a->prev == NULL);
+  ASSERT (b->next == NULL && b->prev == NULL);
+
+  if (h->less (b, a, h->aux))
+    {
+      struct heap_elem *t = a;
+      a = b;
+      b = t;
+    }
+
+  /* Make B the leftmost child of A. */
+  b->next = a->child;
+  if (b->next != NULL)
+    b->next->prev = b;
+  b->prev = a;
+  a->child = b;
+
+  return a;
+}
+
+/* Merges the sibling list starting at FIRST into a single heap
+   using the two-pass pairing strategy and returns its root, or a
+   null pointer if FIRST is null.  Iterative, so that a long
+   sibling list cannot overflow the kernel stack. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first)
+{
+  struct heap_elem *pairs = NULL;
+  struct heap_elem *root = NULL;
+
+  /* First pass: link adjacent pairs from left to right, pushing
+     each result onto PAIRS, which ends up in reverse order. */
+  while (first != NULL)
+    {
+      struct heap_elem *a = first;
+      struct heap_elem *b = a->next;
+
+      if (b != NULL)
+        {
+          first = b->next;
+          a->next = a->prev = NULL;
+          b->next = b->prev = NULL;
+          a = link (h, a, b);
+        }
+      else
+        {
+          first = NULL;
+          a->next = a->prev = NULL;
+        }
+
+      a->next = pairs;
+      pairs = a;
+    }
+
+  /* Second pass: link the pairs from right to left. */
+  while (pairs != NULL)
+    {
+      struct heap_elem *next = pairs->next;
+
+      pairs->next = NULL;
+      root = root != NULL ? link (h, root, pairs) : pairs;
+      pairs = next;
+    }
+
+  return root;
+}
+
+/* Removes non-root element E from its parent's list of
+   children. */
+static void
+detach (struct heap_elem *e)
+{
+  ASSERT (e->prev != NULL);
+
+  if (e->prev->child == e)
+    e->prev->child = e->next;
+  else
+    e->prev->next = e->next;
+  if (e->next != NULL)
+    e->next->prev = e->prev;
+  e->next = e->prev = NULL;
+}
@@ -0,0 +1,76 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue.
+
+   This is a pairing heap, a kind of min-heap that is simple to
+   implement and fast in practice.  Inserting an element and
+   finding the minimum take O(1) time.  Removing the minimum, or
+   removing an arbitrary element, takes O(lg n) amortized time.
+
+   Like the list and hash table implementations, the heap does
+   not use dynamically allocated memory.  Instead, each structure
+   that can potentially be in a heap must embed a struct
+   heap_elem member.  All of the heap functions operate on these
+   `struct heap_elem's.  The heap_entry macro allows conversion
+   from a struct heap_elem back to a structure object that
+   contains it.  Refer to lib/kernel/list.h for a detailed
+   explanation of this technique.
+
+   The heap orders its elements with a caller-supplied "less
+   than" function.  heap_top() returns an element that no other
+   element is less than.  Elements that compare equal are not
+   returned in any particular order.
+
+   None of the heap functions synchronize.  The caller must
+   provide whatever locking (or interrupt disabling) is needed. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem
+  {
+    struct heap_elem *child;    /* Leftmost child. */
+    struct heap_elem *next;     /* Next sibling to the right. */
+    struct heap_elem *prev;     /* Left sibling, or parent if leftmost. */
+  };
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+        ((STRUCT *) ((uint8_t *) (HEAP_ELEM)            \
+                     - offsetof (STRUCT, MEMBER)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap
+  {
+    struct heap_elem *root;     /* Minimum element, or null if empty. */
+    size_t elem_cnt;            /* Number of elements in heap. */
+    heap_less_func *less;       /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+/* Insertion and removal. */
+void heap_push (struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+
+/* Inspection. */
+struct heap_elem *heap_top (const struct heap *);
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
@@ -0,0 +1,21 @@
+#ifndef __LIB_SCHEDSTAT_H
+#define __LIB_SCHEDSTAT_H
+
+#include <stdint.h>
+
+/* Per-thread scheduler statistics, as kept by the kernel and
+   returned to user programs by the schedstat system call.  All
+   times are in timer ticks. */
+struct schedstat
+  {
+    int64_t run_ticks;          /* Ticks spent running. */
+    int64_t wait_ticks;         /* Ticks spent ready but not running. */
+    uint32_t voluntary_cnt;     /* Switches from blocking or yielding. */
+    uint32_t involuntary_cnt;   /* Switches from being preempted. */
+    uint32_t wakeup_cnt;        /* # of times woken up from blocking. */
+    int64_t wakeup_ticks;       /* Total ticks from wakeup to running. */
+    int64_t wakeup_max;         /* Longest time from wakeup to running. */
+    int64_t overrun_max;        /* Most ticks run past a time slice. */
+  };
+
+#endif /* lib/schedstat.h */
@@ -20,6 +20,18 @@ enum
     SYS_CLOSE,                  /* Close a file. */
     SYS_FIBO,                   /* Print answer of fibonacci. */
     SYS_MAX,                    /* Print answer of max_of_four_int. */
+    SYS_SCHEDSTAT,              /* Obtain a thread's scheduler statistics. */
+    SYS_SET_TICKETS,            /* Set stride scheduler tickets. */
+    SYS_SET_DEADLINE,           /* Enter or leave the real-time class. */
+    SYS_THREAD_CREATE,          /* Start another thread in this process. */
+    SYS_THREAD_JOIN,            /* Wait for a thread to exit. */
+    SYS_THREAD_EXIT,            /* Terminate the calling thread. */
+    SYS_PIPE,                   /* Create a pipe. */
+    SYS_READV,                  /* Read into several buffers. */
+    SYS_WRITEV,                 /* Write from several buffers. */
+    SYS_PREAD,                  /* Read at a given file position. */
+    SYS_PWRITE,                 /* Write at a given file position. */
+    SYS_VMSTAT,                 /* Obtain virtual memory statistics. */
 
     /* Project 3 and optionally project 4. */
     SYS_MMAP,                   /* Map a file into memory. */
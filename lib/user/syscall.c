@@ -1,16 +1,30 @@
 #include <syscall.h>
 #include "../syscall-nr.h"
 
+/* Whether system calls enter the kernel through SYSENTER rather
+   than int $0x30.  Set by syscall_probe() at startup. */
+bool syscall_sysenter;
+
+/* Enters the kernel to make a system call whose number and
+   arguments have been pushed on the stack.  SYSENTER takes the
+   user stack pointer in %ecx and the return address in %edx, so
+   each syscallN() macro clobbers those registers whichever path
+   is taken. */
+#define SYSCALL_TRAP                                            \
+        "cmpb $0, syscall_sysenter; je 2f; "                    \
+        "movl %%esp, %%ecx; movl $1f, %%edx; sysenter; "        \
+        "2: int $0x30; 1: "
+
 /* Invokes syscall NUMBER, passing no arguments, and returns the
    return value as an `int'. */
 #define syscall0(NUMBER)                                        \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
-            ("pushl %[number]; int $0x30; addl $4, %%esp"       \
+            ("pushl %[number]; " SYSCALL_TRAP "addl $4, %%esp"  \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER)                          \
-               : "memory");                                     \
+               : "ecx", "edx", "memory");                       \
           retval;                                               \
         })
 
@@ -20,11 +34,11 @@
         ({                                                               \
           int retval;                                                    \
           asm volatile                                                   \
-            ("pushl %[arg0]; pushl %[number]; int $0x30; addl $8, %%esp" \
+            ("pushl %[arg0]; pushl %[number]; " SYSCALL_TRAP "addl $8, %%esp" \
                : "=a" (retval)                                           \
                : [number] "i" (NUMBER),                                  \
                  [arg0] "g" (ARG0)                                       \
-               : "memory");                                              \
+               : "ecx", "edx", "memory");                                \
           retval;                                                        \
         })
 
@@ -35,12 +49,12 @@
           int retval;                                           \
           asm volatile                                          \
             ("pushl %[arg1]; pushl %[arg0]; "                   \
-             "pushl %[number]; int $0x30; addl $12, %%esp"      \
+             "pushl %[number]; " SYSCALL_TRAP "addl $12, %%esp" \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER),                         \
                  [arg0] "r" (ARG0),                             \
                  [arg1] "r" (ARG1)                              \
-               : "memory");                                     \
+               : "ecx", "edx", "memory");                       \
           retval;                                               \
         })
 
@@ -51,13 +65,13 @@
           int retval;                                           \
           asm volatile                                          \
             ("pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "    \
-             "pushl %[number]; int $0x30; addl $16, %%esp"      \
+             "pushl %[number]; " SYSCALL_TRAP "addl $16, %%esp" \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER),                         \
                  [arg0] "r" (ARG0),                             \
                  [arg1] "r" (ARG1),                             \
                  [arg2] "r" (ARG2)                              \
-               : "memory");                                     \
+               : "ecx", "edx", "memory");                       \
           retval;                                               \
         })
 
@@ -68,17 +82,33 @@
           int retval;                                                       \
           asm volatile                                                      \
             ("pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; " \
-             "pushl %[number]; int $0x30; addl $20, %%esp"                  \
+             "pushl %[number]; " SYSCALL_TRAP "addl $20, %%esp"             \
                : "=a" (retval)                                              \
                : [number] "i" (NUMBER),                                     \
                  [arg0] "r" (ARG0),                                         \
                  [arg1] "r" (ARG1),                                         \
                  [arg2] "r" (ARG2),                                         \
                  [arg3] "r" (ARG3)                                          \
-               : "memory");                                                 \
+               : "ecx", "edx", "memory");                                   \
           retval;                                                           \
         })
 
+/* Sets syscall_sysenter if the CPU supports SYSENTER, by the
+   same test the kernel uses to decide whether to enable it. */
+void
+syscall_probe (void)
+{
+  unsigned eax, ebx, ecx, edx;
+  unsigned family, model, stepping;
+
+  asm ("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1));
+  family = (eax >> 8) & 0xf;
+  model = (eax >> 4) & 0xf;
+  stepping = eax & 0xf;
+  syscall_sysenter = ((edx & (1u << 11)) != 0
+                      && !(family == 6 && model < 3 && stepping < 3));
+}
+
 int
 fibonacci(int n)
 {
@@ -91,6 +121,79 @@ max_of_four_int(int a, int b, int c, int d)
   return syscall4 (SYS_MAX, a, b, c, d);
 }
 
+bool
+schedstat (pid_t pid, struct schedstat *st)
+{
+  return syscall2 (SYS_SCHEDSTAT, pid, st);
+}
+
+bool
+set_tickets (int tickets)
+{
+  return syscall1 (SYS_SET_TICKETS, tickets);
+}
+
+bool
+set_deadline (int runtime, int deadline, int period)
+{
+  return syscall3 (SYS_SET_DEADLINE, runtime, deadline, period);
+}
+
+int
+sys_thread_create (void (*start) (void), void (*func) (void *), void *aux)
+{
+  return syscall3 (SYS_THREAD_CREATE, start, func, aux);
+}
+
+bool
+sys_thread_join (int tid)
+{
+  return syscall1 (SYS_THREAD_JOIN, tid);
+}
+
+void
+sys_thread_exit (void)
+{
+  syscall0 (SYS_THREAD_EXIT);
+  NOT_REACHED ();
+}
+
+bool
+pipe (int fds[2])
+{
+  return syscall1 (SYS_PIPE, fds);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, unsigned offset)
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+bool
+vmstat (struct vmstat *st)
+{
+  return syscall1 (SYS_VMSTAT, st);
+}
+
 void
 halt (void) 
 {
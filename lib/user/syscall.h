@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <schedstat.h>
+#include <iovec.h>
+#include <vmstat.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -19,6 +22,13 @@ typedef int mapid_t;
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
 
+/* System call entry.  If syscall_sysenter is true, system calls
+   use SYSENTER instead of int $0x30.  _start() sets it, by calling
+   syscall_probe(), if the CPU supports SYSENTER.  A program may
+   clear it to force the int $0x30 path. */
+extern bool syscall_sysenter;
+void syscall_probe (void);
+
 /* Projects 2 and later. */
 void halt (void) NO_RETURN;
 void exit (int status) NO_RETURN;
@@ -37,6 +47,21 @@ void close (int fd);
 // Additional syscall
 int fibonacci(int n);
 int max_of_four_int(int a, int b, int c, int d);
+bool schedstat (pid_t, struct schedstat *);
+bool set_tickets (int tickets);
+bool set_deadline (int runtime, int deadline, int period);
+
+/* Raw thread system calls.  Use the wrappers in <thread.h>. */
+int sys_thread_create (void (*start) (void), void (*func) (void *),
+                       void *aux);
+bool sys_thread_join (int tid);
+void sys_thread_exit (void) NO_RETURN;
+bool pipe (int fds[2]);
+int readv (int fd, const struct iovec *, int iovcnt);
+int writev (int fd, const struct iovec *, int iovcnt);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+bool vmstat (struct vmstat *);
 
 /* Project 3 and optionally project 4. */
 mapid_t mmap (int fd, void *addr);
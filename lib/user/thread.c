@@ -0,0 +1,39 @@
+#include <thread.h>
+#include <syscall.h>
+
+/* Where each new thread starts running.  The kernel passes along
+   the FUNC and AUX given to thread_create() on the new thread's
+   stack. */
+static void
+start (thread_func *func, void *aux)
+{
+  func (aux);
+  thread_exit ();
+}
+
+/* Starts a new thread that runs FUNC(AUX) and then exits.
+   Returns the new thread's tid, or TID_ERROR if it could not be
+   created. */
+tid_t
+thread_create (thread_func *func, void *aux)
+{
+  return sys_thread_create ((void (*) (void)) start, func, aux);
+}
+
+/* Waits for thread TID, another thread in this process, to exit.
+   Each thread may be joined only once.  Returns true if
+   successful, false if TID is not a joinable thread. */
+bool
+thread_join (tid_t tid)
+{
+  return sys_thread_join (tid);
+}
+
+/* Terminates the calling thread.  If it is the process's initial
+   thread, the process exits with status 0 once all its other
+   threads have exited. */
+void
+thread_exit (void)
+{
+  sys_thread_exit ();
+}
@@ -0,0 +1,24 @@
+#ifndef __LIB_USER_THREAD_H
+#define __LIB_USER_THREAD_H
+
+#include <debug.h>
+#include <stdbool.h>
+
+/* Threads within a user process.
+
+   All the threads of a process share its address space and open
+   files.  Each has a stack of its own, of up to 1 MB.  Calling
+   exit() from any thread terminates the whole process. */
+
+/* Thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
+/* A thread's main function. */
+typedef void thread_func (void *aux);
+
+tid_t thread_create (thread_func *, void *aux);
+bool thread_join (tid_t);
+void thread_exit (void) NO_RETURN;
+
+#endif /* lib/user/thread.h */
@@ -0,0 +1,23 @@
+#ifndef __LIB_VMSTAT_H
+#define __LIB_VMSTAT_H
+
+#include <stdint.h>
+
+/* Longest page replacement policy name, not including the null
+   terminator. */
+#define VMSTAT_POLICY_MAX 15
+
+/* System-wide virtual memory statistics, as kept by the kernel
+   and returned to user programs by the vmstat system call. */
+struct vmstat
+  {
+    char policy[VMSTAT_POLICY_MAX + 1]; /* Page replacement policy. */
+    uint32_t frame_cnt;         /* Frames in the user pool. */
+    uint32_t fault_cnt;         /* Pages brought into a frame. */
+    uint32_t evict_cnt;         /* Pages evicted to free a frame. */
+    uint32_t swap_out_cnt;      /* Evicted pages written to swap. */
+    uint32_t stall_cnt;         /* Allocations that waited for eviction. */
+    uint32_t stall_ticks;       /* Timer ticks spent waiting. */
+  };
+
+#endif /* lib/vmstat.h */
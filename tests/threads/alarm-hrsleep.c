@@ -0,0 +1,75 @@
+/* Checks that timer_usleep() sleeps for at least as long as it
+   is asked to, without rounding up to whole timer ticks, and
+   that sub-tick sleeps block instead of spinning.
+
+   The main thread sleeps for a range of intervals, from much
+   less than a tick to a few ticks, and measures each with
+   timer_ns().  A lower-priority thread spins meanwhile; if the
+   main thread blocks while it sleeps, the spinner gets to
+   run. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* How late a sleep may end, in nanoseconds.  This is generous,
+   to allow for slow emulators, but still less than the tick that
+   rounding up to whole ticks would cost. */
+#define SLACK_NS (5 * 1000 * 1000)
+
+static const int sleep_us[] = {100, 700, 4000, 25000};
+
+static volatile bool done;
+static volatile unsigned spin_cnt;
+static struct semaphore spinner_done;
+
+static thread_func spinner;
+
+void
+test_alarm_hrsleep (void) 
+{
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&spinner_done, 0);
+  thread_create ("spinner", PRI_DEFAULT - 1, spinner, NULL);
+
+  for (i = 0; i < sizeof sleep_us / sizeof *sleep_us; i++)
+    {
+      int64_t ns = (int64_t) sleep_us[i] * 1000;
+      unsigned spin_start = spin_cnt;
+      int64_t start = timer_ns ();
+      int64_t elapsed;
+
+      timer_usleep (sleep_us[i]);
+      elapsed = timer_ns () - start;
+
+      if (elapsed < ns)
+        fail ("timer_usleep (%d) returned after only %lld ns",
+              sleep_us[i], elapsed);
+      if (elapsed > ns + SLACK_NS)
+        fail ("timer_usleep (%d) returned after %lld ns",
+              sleep_us[i], elapsed);
+      msg ("timer_usleep (%d) returned on time.", sleep_us[i]);
+
+      /* The shortest sleep spins; the rest should block. */
+      if (i > 0 && spin_cnt == spin_start)
+        fail ("timer_usleep (%d) did not block", sleep_us[i]);
+    }
+
+  done = true;
+  sema_down (&spinner_done);
+}
+
+static void
+spinner (void *aux UNUSED) 
+{
+  while (!done)
+    spin_cnt++;
+  sema_up (&spinner_done);
+}
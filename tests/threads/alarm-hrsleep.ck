@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-hrsleep) begin
+(alarm-hrsleep) timer_usleep (100) returned on time.
+(alarm-hrsleep) timer_usleep (700) returned on time.
+(alarm-hrsleep) timer_usleep (4000) returned on time.
+(alarm-hrsleep) timer_usleep (25000) returned on time.
+(alarm-hrsleep) end
+EOF
+pass;
@@ -0,0 +1,38 @@
+/* Checks that a real-time thread cannot run for longer than its
+   budget.  The main thread enters the real-time class with a
+   runtime of 3 ticks in every period of 10 and then tries to
+   spin for 200 ticks.  It should be throttled after 3 ticks of
+   each period, so that it sees only about 60 of the 200 ticks
+   go by. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define RUNTIME 3
+#define PERIOD 10
+#define SPIN_TICKS 200
+
+void
+test_edf_budget (void) 
+{
+  int64_t start_time, last_time;
+  int tick_count = 0;
+
+  if (!thread_set_deadline (RUNTIME, PERIOD, PERIOD))
+    fail ("main thread refused admission");
+
+  start_time = last_time = timer_ticks ();
+  while (timer_elapsed (start_time) < SPIN_TICKS)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        tick_count++;
+      last_time = cur_time;
+    }
+  thread_set_deadline (0, 0, 0);
+
+  msg ("Main thread received %d of %d ticks.", tick_count, SPIN_TICKS);
+}
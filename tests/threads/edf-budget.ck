@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+my ($count);
+foreach (@output) {
+    ($count) = /Main thread received (\d+) of 200 ticks\./ and last;
+}
+fail "missing tick count\n" if !defined $count;
+fail "received $count ticks, expected between 50 and 70\n"
+  if $count < 50 || $count > 70;
+pass;
@@ -0,0 +1,91 @@
+/* Checks that real-time threads run earliest deadline first,
+   ahead of ordinary threads regardless of priority, and that
+   admission control turns away a thread that would overload the
+   real-time class.
+
+   Two real-time threads, with deadlines of 50 and 30 ticks,
+   lower their priorities to PRI_MIN.  An ordinary thread with a
+   higher priority than the main thread asks for too much of the
+   CPU and is refused.  All three then wait while the main
+   thread, itself in the real-time class with the earliest
+   deadline, wakes them.  When the main thread leaves the class,
+   they should run in deadline order, then the ordinary thread,
+   then the main thread. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+struct rt_info
+  {
+    int deadline;               /* Deadline and period, 0 if ordinary. */
+    struct semaphore sema;      /* Upped by the main thread. */
+  };
+
+static thread_func rt_thread_func;
+static thread_func normal_thread_func;
+
+void
+test_edf_order (void) 
+{
+  struct rt_info late, early, normal;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  if (thread_set_deadline (5, 4, 10))
+    fail ("runtime longer than deadline was accepted");
+  msg ("Runtime longer than deadline refused.");
+
+  late.deadline = 50;
+  sema_init (&late.sema, 0);
+  thread_create ("rt 50", PRI_DEFAULT + 1, rt_thread_func, &late);
+  early.deadline = 30;
+  sema_init (&early.sema, 0);
+  thread_create ("rt 30", PRI_DEFAULT + 1, rt_thread_func, &early);
+  normal.deadline = 0;
+  sema_init (&normal.sema, 0);
+  thread_create ("normal", PRI_DEFAULT + 1, normal_thread_func, &normal);
+
+  msg ("main: entering the real-time class.");
+  if (!thread_set_deadline (10, 20, 20))
+    fail ("main thread refused admission");
+  sema_up (&normal.sema);
+  sema_up (&late.sema);
+  sema_up (&early.sema);
+  msg ("main: leaving the real-time class.");
+  thread_set_deadline (0, 0, 0);
+  msg ("main: done.");
+}
+
+static void
+rt_thread_func (void *info_) 
+{
+  struct rt_info *info = info_;
+
+  if (!thread_set_deadline (5, info->deadline, info->deadline))
+    fail ("%s: refused admission", thread_name ());
+  msg ("%s: admitted.", thread_name ());
+  thread_set_priority (PRI_MIN);
+  sema_down (&info->sema);
+  msg ("%s: running.", thread_name ());
+}
+
+static void
+normal_thread_func (void *info_) 
+{
+  struct rt_info *info = info_;
+
+  /* 7/10 of the CPU on top of the 1/10 and 1/6 already admitted
+     is more than the class may use. */
+  if (thread_set_deadline (7, 10, 10))
+    fail ("normal: admitted");
+  msg ("normal: refused admission.");
+  sema_down (&info->sema);
+  msg ("normal: running.");
+}
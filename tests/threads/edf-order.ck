@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(edf-order) begin
+(edf-order) Runtime longer than deadline refused.
+(edf-order) rt 50: admitted.
+(edf-order) rt 30: admitted.
+(edf-order) normal: refused admission.
+(edf-order) main: entering the real-time class.
+(edf-order) main: leaving the real-time class.
+(edf-order) rt 30: running.
+(edf-order) rt 50: running.
+(edf-order) normal: running.
+(edf-order) main: done.
+(edf-order) end
+EOF
+pass;
@@ -0,0 +1,60 @@
+/* The main thread acquires a readers-writer lock for reading.
+   A higher-priority reader then gets it at once, because readers
+   share the lock.  A writer that comes next has to wait for the
+   main thread, and a reader that arrives while the writer is
+   waiting, with lower priority than the writer, has to wait too.
+   When the main thread releases the lock, the writer should get
+   it first, then the second reader. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_priority_rwlock (void) 
+{
+  struct rwlock rwlock;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rwlock);
+  rwlock_acquire_read (&rwlock);
+  thread_create ("reader1", PRI_DEFAULT + 1, reader_thread_func, &rwlock);
+  thread_create ("writer", PRI_DEFAULT + 2, writer_thread_func, &rwlock);
+  thread_create ("reader2", PRI_DEFAULT + 1, reader_thread_func, &rwlock);
+  msg ("main: releasing the lock");
+  rwlock_release_read (&rwlock);
+  msg ("writer, reader2 must already have finished, in that order.");
+  msg ("This should be the last line before finishing this test.");
+}
+
+static void
+reader_thread_func (void *rwlock_) 
+{
+  struct rwlock *rwlock = rwlock_;
+
+  rwlock_acquire_read (rwlock);
+  msg ("%s: got the lock for reading", thread_name ());
+  rwlock_release_read (rwlock);
+  msg ("%s: done", thread_name ());
+}
+
+static void
+writer_thread_func (void *rwlock_) 
+{
+  struct rwlock *rwlock = rwlock_;
+
+  rwlock_acquire_write (rwlock);
+  msg ("writer: got the lock for writing");
+  rwlock_release_write (rwlock);
+  msg ("writer: done");
+}
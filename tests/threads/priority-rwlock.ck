@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-rwlock) begin
+(priority-rwlock) reader1: got the lock for reading
+(priority-rwlock) reader1: done
+(priority-rwlock) main: releasing the lock
+(priority-rwlock) writer: got the lock for writing
+(priority-rwlock) writer: done
+(priority-rwlock) reader2: got the lock for reading
+(priority-rwlock) reader2: done
+(priority-rwlock) writer, reader2 must already have finished, in that order.
+(priority-rwlock) This should be the last line before finishing this test.
+(priority-rwlock) end
+EOF
+pass;
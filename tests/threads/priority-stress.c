@@ -0,0 +1,123 @@
+/* Creates a few hundred threads at the same priority, has them
+   all yield to each other round-robin, and reports how long
+   interrupts stay off from the moment one thread yields until
+   the next one resumes.  With a constant-time run queue this
+   should not depend on the number of runnable threads, so the
+   test runs once with a handful of threads and once with many
+   and prints both.
+
+   Timing is done with the processor's time-stamp counter, so the
+   figures are in CPU cycles and vary from run to run; the .ck
+   file only checks that both rounds completed. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define FEW_THREAD_CNT 4
+#define MANY_THREAD_CNT 256
+#define YIELD_CNT 32
+
+/* Time-stamp counter at the moment the last thread to yield
+   gave up the CPU, or 0 if no yield is in progress. */
+static uint64_t switch_start;
+
+/* Statistics for the current round. */
+static uint64_t switch_cycles;
+static uint64_t switch_max;
+static unsigned switch_cnt;
+static int finished_cnt;
+
+static thread_func stress_thread;
+static void run_round (int thread_cnt);
+
+void
+test_priority_stress (void)
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  run_round (FEW_THREAD_CNT);
+  run_round (MANY_THREAD_CNT);
+}
+
+/* Creates THREAD_CNT threads that each yield YIELD_CNT times,
+   waits for them to finish, and prints the switch statistics. */
+static void
+run_round (int thread_cnt)
+{
+  int i;
+
+  switch_start = 0;
+  switch_cycles = switch_max = 0;
+  switch_cnt = 0;
+  finished_cnt = 0;
+
+  msg ("%d threads yielding %d times each.", thread_cnt, YIELD_CNT);
+
+  thread_set_priority (PRI_DEFAULT + 2);
+  for (i = 0; i < thread_cnt; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "%d", i);
+      if (thread_create (name, PRI_DEFAULT + 1, stress_thread, NULL)
+          == TID_ERROR)
+        fail ("thread_create failed for thread %d", i);
+    }
+
+  /* All the other threads now run to termination here. */
+  thread_set_priority (PRI_DEFAULT);
+
+  if (finished_cnt != thread_cnt)
+    fail ("only %d of %d threads finished", finished_cnt, thread_cnt);
+  if (switch_cnt == 0)
+    fail ("no thread switches were measured");
+
+  msg ("%d threads: %"PRIu64" cycles average, %"PRIu64" cycles maximum "
+       "with interrupts off per schedule (%u schedules).",
+       thread_cnt, switch_cycles / switch_cnt, switch_max, switch_cnt);
+}
+
+static void
+stress_thread (void *aux UNUSED)
+{
+  enum intr_level old_level;
+  int i;
+
+  for (i = 0; i < YIELD_CNT; i++)
+    {
+      uint64_t now;
+
+      old_level = intr_disable ();
+      switch_start = rdtsc ();
+      thread_yield ();
+      now = rdtsc ();
+
+      /* We resumed from thread_yield(), so the thread that ran
+         just before us set switch_start right before giving up
+         the CPU.  Threads starting up for the first time do not
+         come back through here, so they never consume it. */
+      if (switch_start != 0)
+        {
+          uint64_t cycles = now - switch_start;
+          switch_cycles += cycles;
+          if (cycles > switch_max)
+            switch_max = cycles;
+          switch_cnt++;
+        }
+      switch_start = 0;
+      intr_set_level (old_level);
+    }
+
+  old_level = intr_disable ();
+  finished_cnt++;
+  intr_set_level (old_level);
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+for my $cnt (4, 256) {
+    fail "missing statistics for $cnt threads"
+      unless grep (/^\(priority-stress\) $cnt threads: \d+ cycles average, \d+ cycles maximum with interrupts off per schedule \(\d+ schedules\)\.$/, @output);
+}
+fail "missing end of test in output"
+  unless grep ($_ eq '(priority-stress) end', @output);
+
+pass;
@@ -17,6 +17,7 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-hrsleep", test_alarm_hrsleep},
     {"priority-change", test_priority_change},
     {"priority-change-2", test_priority_change_2},
     {"priority-donate-one", test_priority_donate_one},
@@ -32,6 +33,11 @@ static const struct test tests[] =
     {"priority-sema", test_priority_sema},
     {"priority-aging", test_priority_aging},
     {"priority-condvar", test_priority_condvar},
+    {"priority-stress", test_priority_stress},
+    {"priority-rwlock", test_priority_rwlock},
+    {"edf-order", test_edf_order},
+    {"edf-budget", test_edf_budget},
+    {"stride-share", test_stride_share},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -11,6 +11,7 @@ extern test_func test_alarm_simultaneous;
 extern test_func test_alarm_priority;
 extern test_func test_alarm_zero;
 extern test_func test_alarm_negative;
+extern test_func test_alarm_hrsleep;
 extern test_func test_priority_change;
 extern test_func test_priority_change_2;
 extern test_func test_priority_donate_one;
@@ -26,6 +27,11 @@ extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_aging;
 extern test_func test_priority_condvar;
+extern test_func test_priority_stress;
+extern test_func test_priority_rwlock;
+extern test_func test_edf_order;
+extern test_func test_edf_budget;
+extern test_func test_stride_share;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -0,0 +1,33 @@
+/* Opens more files than the old fixed-size descriptor table
+   could hold, then checks that closing a descriptor makes it
+   the next one handed out. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define OPEN_CNT 300
+
+void
+test_main (void)
+{
+  static int fds[OPEN_CNT];
+  int i;
+
+  for (i = 0; i < OPEN_CNT; i++)
+    {
+      fds[i] = open ("sample.txt");
+      if (fds[i] < 2)
+        fail ("open #%d returned %d", i, fds[i]);
+      if (i > 0 && fds[i] != fds[i - 1] + 1)
+        fail ("open #%d returned %d after %d", i, fds[i], fds[i - 1]);
+    }
+  msg ("opened \"sample.txt\" %d times", OPEN_CNT);
+
+  close (fds[10]);
+  CHECK (open ("sample.txt") == fds[10], "lowest free descriptor reused");
+
+  for (i = 0; i < OPEN_CNT; i++)
+    close (fds[i]);
+  CHECK (open ("sample.txt") == fds[0], "descriptors freed by close");
+}
@@ -0,0 +1,29 @@
+/* Creates a pipe, writes to one end and reads back from the
+   other, then checks that reading after the write end is closed
+   returns end of file. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  static const char msg_text[] = "Through the pipe.";
+  char buf[64];
+  int fds[2];
+
+  CHECK (pipe (fds), "pipe");
+  CHECK (fds[0] > 2 && fds[1] > 2 && fds[0] != fds[1],
+         "got distinct descriptors");
+  CHECK (write (fds[1], msg_text, sizeof msg_text) == sizeof msg_text,
+         "write to pipe");
+  CHECK (read (fds[0], buf, sizeof buf) == sizeof msg_text,
+         "read from pipe");
+  if (strcmp (buf, msg_text))
+    fail ("read \"%s\" instead of \"%s\"", buf, msg_text);
+  close (fds[1]);
+  CHECK (read (fds[0], buf, sizeof buf) == 0, "read at end of file");
+  close (fds[0]);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-simple) begin
+(pipe-simple) pipe
+(pipe-simple) got distinct descriptors
+(pipe-simple) write to pipe
+(pipe-simple) read from pipe
+(pipe-simple) read at end of file
+(pipe-simple) end
+pipe-simple: exit(0)
+EOF
+pass;
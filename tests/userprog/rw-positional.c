@@ -0,0 +1,27 @@
+/* Uses pwrite() and pread() at explicit offsets and checks that
+   they neither use nor change the file position. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf[8];
+  int fd;
+
+  CHECK (create ("positional", 16), "create \"positional\"");
+  CHECK ((fd = open ("positional")) > 1, "open \"positional\"");
+  seek (fd, 3);
+  CHECK (pwrite (fd, "abcdefgh", 8, 8) == 8, "pwrite at offset 8");
+  CHECK (tell (fd) == 3, "position unchanged by pwrite");
+  CHECK (pread (fd, buf, 4, 10) == 4, "pread at offset 10");
+  if (memcmp (buf, "cdef", 4))
+    fail ("pread returned wrong data");
+  CHECK (tell (fd) == 3, "position unchanged by pread");
+  CHECK (pread (fd, buf, sizeof buf, 16) == 0, "pread at end of file");
+  CHECK (pread (0, buf, sizeof buf, 0) == -1, "pread from console fails");
+  close (fd);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rw-positional) begin
+(rw-positional) create "positional"
+(rw-positional) open "positional"
+(rw-positional) pwrite at offset 8
+(rw-positional) position unchanged by pwrite
+(rw-positional) pread at offset 10
+(rw-positional) position unchanged by pread
+(rw-positional) pread at end of file
+(rw-positional) pread from console fails
+(rw-positional) end
+rw-positional: exit(0)
+EOF
+pass;
@@ -0,0 +1,29 @@
+/* Writes a file with writev() from three buffers, then reads it
+   back with readv() into differently sized buffers and checks
+   the contents. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  static char a[] = "Vectored ", b[] = "I/O ", c[] = "works.";
+  char x[5], y[14];
+  struct iovec out[3] = {{a, 9}, {b, 4}, {c, 6}};
+  struct iovec in[2] = {{x, sizeof x}, {y, sizeof y}};
+  int fd;
+
+  CHECK (create ("vector", 0), "create \"vector\"");
+  CHECK ((fd = open ("vector")) > 1, "open \"vector\"");
+  CHECK (writev (fd, out, 3) == 19, "writev 3 buffers");
+  seek (fd, 0);
+  CHECK (readv (fd, in, 2) == 19, "readv 2 buffers");
+  if (memcmp (x, "Vecto", 5) || memcmp (y, "red I/O works.", 14))
+    fail ("readv returned wrong data");
+  CHECK (readv (fd, in, 2) == 0, "readv at end of file");
+  CHECK (readv (fd, in, IOV_MAX + 1) == -1, "readv too many buffers");
+  close (fd);
+}
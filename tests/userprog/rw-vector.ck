@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rw-vector) begin
+(rw-vector) create "vector"
+(rw-vector) open "vector"
+(rw-vector) writev 3 buffers
+(rw-vector) readv 2 buffers
+(rw-vector) readv at end of file
+(rw-vector) readv too many buffers
+(rw-vector) end
+rw-vector: exit(0)
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Calls exit() from a second thread while a third thread spins
+   in user mode and the initial thread waits to join it.  The
+   whole process must exit with the second thread's status. */
+
+#include <syscall.h>
+#include <thread.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static void
+spin (void *aux UNUSED)
+{
+  for (;;)
+    continue;
+}
+
+static void
+do_exit (void *aux UNUSED)
+{
+  exit (57);
+}
+
+void
+test_main (void)
+{
+  tid_t spinner = thread_create (spin, NULL);
+
+  CHECK (spinner != TID_ERROR, "create spinner");
+  CHECK (thread_create (do_exit, NULL) != TID_ERROR, "create exiter");
+  thread_join (spinner);
+  fail ("should have exited with status 57");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(uthread-exit) begin
+(uthread-exit) create spinner
+(uthread-exit) create exiter
+uthread-exit: exit(57)
+EOF
+pass;
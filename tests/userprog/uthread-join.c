@@ -0,0 +1,51 @@
+/* Starts several threads in the same process that each sum a
+   slice of a shared array into a shared result array, joins
+   them, and checks the sums.  Also checks that a thread cannot
+   be joined twice and that joining a bogus tid fails. */
+
+#include <thread.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define SLICE 1000
+
+static int values[THREAD_CNT * SLICE];
+static int sums[THREAD_CNT];
+
+static void
+sum_slice (void *slice_)
+{
+  int slice = (int) slice_;
+  int i;
+
+  for (i = slice * SLICE; i < (slice + 1) * SLICE; i++)
+    sums[slice] += values[i];
+}
+
+void
+test_main (void)
+{
+  tid_t tids[THREAD_CNT];
+  int i;
+
+  for (i = 0; i < THREAD_CNT * SLICE; i++)
+    values[i] = i;
+
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK ((tids[i] = thread_create (sum_slice, (void *) i)) != TID_ERROR,
+           "create thread %d", i);
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK (thread_join (tids[i]), "join thread %d", i);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      int expected = SLICE * (2 * i * SLICE + SLICE - 1) / 2;
+      if (sums[i] != expected)
+        fail ("slice %d summed to %d, expected %d", i, sums[i], expected);
+    }
+  msg ("sums correct");
+
+  CHECK (!thread_join (tids[0]), "join thread 0 again (must fail)");
+  CHECK (!thread_join (12345), "join bogus tid (must fail)");
+}
@@ -0,0 +1,90 @@
+/* Keeps a set of hot pages in use while streaming through a
+   region much bigger than memory that is read only once per
+   pass, then reports how many page faults and evictions that
+   took, and how many faults had to wait for the page-out daemon
+   to free a frame.  A policy that tells the hot pages from the
+   streamed ones keeps the hot set resident, so few of its faults
+   happen while touching it.
+
+   The same program runs once under each page replacement
+   policy.  The counts vary from run to run, so the .ck files
+   only check that they were reported. */
+
+#include <inttypes.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define HOT_PAGES 160           /* Pages in the hot set. */
+#define COLD_PAGES 1024         /* Pages in the streamed region. */
+#define SCAN_PAGES 512          /* Streamed pages read per round. */
+#define ROUND_CNT 6
+
+static uint8_t hot[HOT_PAGES * PAGE_SIZE];
+static uint8_t cold[COLD_PAGES * PAGE_SIZE];
+
+/* Writes VALUE to each hot page, after checking that it still
+   holds the value written in the previous round, OLD. */
+static void
+touch_hot (uint8_t old, uint8_t value)
+{
+  size_t i;
+
+  for (i = 0; i < HOT_PAGES; i++)
+    {
+      if (hot[i * PAGE_SIZE] != old)
+        fail ("hot page %zu holds %d, not %d", i, hot[i * PAGE_SIZE], old);
+      hot[i * PAGE_SIZE] = value;
+    }
+}
+
+/* Reads SCAN_PAGES pages of the streamed region, starting at
+   page *NEXT, and advances *NEXT past them. */
+static void
+scan_cold (size_t *next)
+{
+  size_t i;
+
+  for (i = 0; i < SCAN_PAGES; i++)
+    {
+      if (cold[*next * PAGE_SIZE] != 0)
+        fail ("streamed page %zu is not zero", *next);
+      *next = (*next + 1) % COLD_PAGES;
+    }
+}
+
+void
+test_main (void)
+{
+  struct vmstat start, before, after;
+  uint32_t hot_faults = 0;
+  size_t next = 0;
+  int round;
+
+  CHECK (vmstat (&start), "vmstat");
+  msg ("replacement policy: %s", start.policy);
+
+  /* Warm up. */
+  touch_hot (0, 1);
+  scan_cold (&next);
+
+  vmstat (&start);
+  for (round = 1; round <= ROUND_CNT; round++)
+    {
+      vmstat (&before);
+      touch_hot (round, round + 1);
+      vmstat (&after);
+      hot_faults += after.fault_cnt - before.fault_cnt;
+
+      scan_cold (&next);
+    }
+  vmstat (&after);
+
+  msg ("hot set: %"PRIu32" faults", hot_faults);
+  msg ("total: %"PRIu32" faults, %"PRIu32" evictions",
+       after.fault_cnt - start.fault_cnt, after.evict_cnt - start.evict_cnt);
+  msg ("stalls: %"PRIu32" faults waited %"PRIu32" ticks",
+       after.stall_cnt - start.stall_cnt,
+       after.stall_ticks - start.stall_ticks);
+}
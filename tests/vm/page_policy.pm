@@ -0,0 +1,31 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+sub check_page_policy {
+    my ($policy) = @_;
+    my ($name) = "page-policy-$policy";
+    our ($test);
+    my (@output) = read_text_file ("$test.output");
+
+    common_checks ("run", @output);
+    @output = get_core_output ("run", @output);
+    fail "First line of output is not `($name) begin' message.\n"
+      if $output[0] ne "($name) begin";
+    fail "Output does not name the $policy policy.\n"
+      if !grep ("($name) replacement policy: $policy" eq $_, @output);
+    fail "Output missing hot set fault count.\n"
+      if !grep (/^\($name\) hot set: \d+ faults$/, @output);
+    fail "Output missing total fault and eviction counts.\n"
+      if !grep (/^\($name\) total: \d+ faults, \d+ evictions$/, @output);
+    fail "Output missing stall count.\n"
+      if !grep (/^\($name\) stalls: \d+ faults waited \d+ ticks$/, @output);
+    fail "Output missing '($name) end' message.\n"
+      if !grep ("($name) end" eq $_, @output);
+    fail "Output missing '$name: exit(0)' message.\n"
+      if !grep ("$name: exit(0)" eq $_, @output);
+    pass;
+}
+
+1;
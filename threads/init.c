@@ -122,12 +122,12 @@ main (void)
 
   /* Start thread scheduler and enable interrupts. */
   thread_start ();
+  intr_defer_start ();
   serial_init_queue ();
   timer_calibrate ();
 
 #ifdef VM
-  swap_init();
-  lru_list_init();
+  frame_table_init();
 #endif
 
 #ifdef FILESYS
@@ -137,6 +137,12 @@ main (void)
   filesys_init (format_filesys);
 #endif
 
+#ifdef VM
+  /* Needs the swap device. */
+  swap_init();
+  frame_start_pageout();
+#endif
+
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -260,12 +266,24 @@ parse_options (char **argv)
 #ifdef VM
       else if (!strcmp (name, "-swap"))
         swap_bdev_name = value;
+      else if (!strcmp (name, "-vmpolicy"))
+        {
+          if (value == NULL || !frame_set_policy (value))
+            PANIC ("unknown page replacement policy `%s'",
+                   value != NULL ? value : "");
+        }
 #endif
 #endif
       else if (!strcmp (name, "-rs"))
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-stride"))
+        thread_stride = true;
+      else if (!strcmp (name, "-nohz"))
+        timer_nohz = true;
+      else if (!strcmp (name, "-lockstat"))
+        lockstat_enabled = true;
 #ifndef USERPROG
       else if (!strcmp (name, "-aging"))
         thread_prior_aging = true;
@@ -278,6 +296,9 @@ parse_options (char **argv)
         PANIC ("unknown option `%s' (use -h for help)", name);
     }
 
+  if (thread_mlfqs && thread_stride)
+    PANIC ("-mlfqs and -stride are mutually exclusive");
+
   /* Initialize the random number generator based on the system
      time.  This has no effect if an "-rs" option was specified.
 
@@ -389,10 +410,15 @@ usage (void)
           "  -scratch=BDEV      Use BDEV for scratch instead of default.\n"
 #ifdef VM
           "  -swap=BDEV         Use BDEV for swap instead of default.\n"
+          "  -vmpolicy=POLICY   Replace pages with POLICY: clock (default),\n"
+          "                     clockpro, or arc.\n"
 #endif
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -stride            Use proportional-share stride scheduler.\n"
+          "  -nohz              Stop the timer tick while the CPU is idle.\n"
+          "  -lockstat          Print lock contention statistics at shutdown.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -8,7 +8,12 @@
 #include "threads/io.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "threads/workqueue.h"
 #include "devices/timer.h"
+#ifdef USERPROG
+#include "userprog/gdt.h"
+#include "userprog/process.h"
+#endif
 
 /* Programmable Interrupt Controller (PIC) registers.
    A PC has two PICs, called the master and slave PICs, with the
@@ -47,6 +52,13 @@ static unsigned int unexpected_cnt[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Work deferred by external interrupt handlers.  A handler only
+   needs to acknowledge its device and pass the rest of its
+   processing to intr_defer().  The deferred work runs soon after
+   in the "softirq" worker thread, at the highest priority but
+   with interrupts enabled. */
+static struct workqueue softirq_wq;
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -123,6 +135,10 @@ intr_init (void)
   /* Initialize interrupt controller. */
   pic_init ();
 
+  /* Initialize deferred work.  Handlers may defer work from now
+     on, but it runs only after intr_defer_start(). */
+  workqueue_init (&softirq_wq, "softirq");
+
   /* Initialize IDT. */
   for (i = 0; i < INTR_CNT; i++)
     idt[i] = make_intr_gate (intr_stubs[i], 0);
@@ -225,6 +241,24 @@ intr_yield_on_return (void)
   yield_on_return = true;
 }
 
+/* Starts running work deferred by interrupt handlers.  Must be
+   called after thread_start(). */
+void
+intr_defer_start (void)
+{
+  workqueue_start (&softirq_wq, PRI_MAX);
+}
+
+/* Defers W to be run in thread context, ahead of all other
+   threads.  Returns false if W was already pending, true
+   otherwise.  Intended for external interrupt handlers, but may
+   be called at any time. */
+bool
+intr_defer (struct work *w)
+{
+  return workqueue_queue (&softirq_wq, w);
+}
+
 /* 8259A Programmable Interrupt Controller. */
 
 /* Initializes the PICs.  Refer to [8259A] for details.
@@ -385,6 +419,16 @@ intr_handler (struct intr_frame *frame)
 
       if (yield_on_return) 
         thread_yield (); 
+
+#ifdef USERPROG
+      /* Don't let a thread return to user mode once another
+         thread has made its process exit. */
+      if (frame->cs == SEL_UCSEG && thread_current ()->leader->exiting)
+        {
+          intr_enable ();
+          process_check_exit ();
+        }
+#endif
     }
 }
 
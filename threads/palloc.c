@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -23,22 +24,45 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool also keeps a small cache of pages that the idle
+   thread has already filled with zeros, so that PAL_ZERO
+   requests for a single page usually need not clear it on the
+   caller's time.  Cached pages are marked used in the pool's
+   bitmap, and they are handed back out when the pool otherwise
+   runs dry. */
+
+/* Most pages to keep zeroed in advance, per pool. */
+#define ZERO_CACHE_MAX 32
 
 /* A memory pool. */
 struct pool
   {
     struct lock lock;                   /* Mutual exclusion. */
+    struct lockstat lockstat;           /* Contention statistics. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
     uint8_t *base;                      /* Base of pool. */
+
+    /* Cache of zeroed pages, linked through their first word. */
+    void *zeroed;                       /* First zeroed page, or null. */
+    size_t zeroed_cnt;                  /* # of pages in cache. */
+    size_t zeroed_max;                  /* Capacity of cache. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/* Zeroed page cache statistics. */
+static long long zero_hit_cnt;          /* PAL_ZERO requests served from cache. */
+static long long zero_miss_cnt;         /* PAL_ZERO requests zeroed inline. */
+static long long prezero_cnt;           /* Pages zeroed by the idle thread. */
+
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static void *zeroed_pop (struct pool *);
+static void zeroed_drain (struct pool *);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -78,7 +102,33 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
     return NULL;
 
   lock_acquire (&pool->lock);
+
+  /* A zeroed single page can come straight from the cache. */
+  if (page_cnt == 1 && (flags & PAL_ZERO) && pool->zeroed != NULL)
+    {
+      pages = zeroed_pop (pool);
+      zero_hit_cnt++;
+      lock_release (&pool->lock);
+      return pages;
+    }
+
   page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+  if (page_idx == BITMAP_ERROR && pool->zeroed != NULL)
+    {
+      if (page_cnt == 1)
+        {
+          /* Out of free pages, but a cached page will do. */
+          pages = zeroed_pop (pool);
+          lock_release (&pool->lock);
+          return pages;
+        }
+
+      /* Give the cached pages back and try again. */
+      zeroed_drain (pool);
+      page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+    }
+  if (page_idx != BITMAP_ERROR && (flags & PAL_ZERO))
+    zero_miss_cnt++;
   lock_release (&pool->lock);
 
   if (page_idx != BITMAP_ERROR)
@@ -148,6 +198,109 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Zeroes one free page in advance and adds it to its pool's
+   cache of zeroed pages.  Returns true if a page was zeroed,
+   false if there was nothing to do because the caches are full,
+   the pools are exhausted, or a pool is busy.
+
+   Called by the idle thread, which must never block, so the
+   pool lock is only tried, and it is held with interrupts off so
+   that the idle thread cannot be preempted while holding it. */
+bool
+palloc_prezero_page (void)
+{
+  struct pool *pools[] = { &kernel_pool, &user_pool };
+  size_t i;
+
+  for (i = 0; i < sizeof pools / sizeof *pools; i++)
+    {
+      struct pool *pool = pools[i];
+      enum intr_level old_level;
+      size_t page_idx = BITMAP_ERROR;
+      void *page;
+
+      old_level = intr_disable ();
+      if (pool->zeroed_cnt < pool->zeroed_max
+          && lock_try_acquire (&pool->lock))
+        {
+          page_idx = bitmap_scan_and_flip (pool->used_map, 0, 1, false);
+          lock_release (&pool->lock);
+        }
+      intr_set_level (old_level);
+      if (page_idx == BITMAP_ERROR)
+        continue;
+
+      page = pool->base + PGSIZE * page_idx;
+      memset (page, 0, PGSIZE);
+
+      old_level = intr_disable ();
+      if (lock_try_acquire (&pool->lock))
+        {
+          /* The first word links the cache; it is cleared again
+             when the page is handed out. */
+          *(void **) page = pool->zeroed;
+          pool->zeroed = page;
+          pool->zeroed_cnt++;
+          prezero_cnt++;
+          lock_release (&pool->lock);
+          page = NULL;
+        }
+      intr_set_level (old_level);
+
+      /* If the pool became busy meanwhile, just free the page. */
+      if (page != NULL)
+        palloc_free_page (page);
+      else
+        return true;
+    }
+  return false;
+}
+
+/* Returns the number of pages in the user pool and stores the
+   address of its first page in *BASE.  Every page that
+   palloc_get_page (PAL_USER) returns lies in this range. */
+size_t
+palloc_user_pool (void **base)
+{
+  *base = user_pool.base;
+  return bitmap_size (user_pool.used_map);
+}
+
+/* Prints zeroed page cache statistics. */
+void
+palloc_print_stats (void)
+{
+  printf ("Palloc: %lld zeroed pages from cache, %lld zeroed inline, "
+          "%lld zeroed while idle\n",
+          zero_hit_cnt, zero_miss_cnt, prezero_cnt);
+}
+
+/* Removes and returns a page from POOL's nonempty cache of
+   zeroed pages.  POOL's lock must be held. */
+static void *
+zeroed_pop (struct pool *pool)
+{
+  void *page = pool->zeroed;
+
+  ASSERT (page != NULL);
+  pool->zeroed = *(void **) page;
+  pool->zeroed_cnt--;
+  *(void **) page = NULL;
+  return page;
+}
+
+/* Returns all of POOL's zeroed pages to its free pages.  POOL's
+   lock must be held. */
+static void
+zeroed_drain (struct pool *pool)
+{
+  while (pool->zeroed != NULL)
+    {
+      void *page = zeroed_pop (pool);
+      bitmap_reset (pool->used_map, pg_no (page) - pg_no (pool->base));
+    }
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
@@ -165,8 +318,12 @@ init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
 
   /* Initialize the pool. */
   lock_init (&p->lock);
+  lock_profile (&p->lock, &p->lockstat, name);
   p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
   p->base = base + bm_pages * PGSIZE;
+  p->zeroed = NULL;
+  p->zeroed_cnt = 0;
+  p->zeroed_max = page_cnt / 16 < ZERO_CACHE_MAX ? page_cnt / 16 : ZERO_CACHE_MAX;
 }
 
 /* Returns true if PAGE was allocated from POOL,
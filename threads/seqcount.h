@@ -0,0 +1,80 @@
+#ifndef THREADS_SEQCOUNT_H
+#define THREADS_SEQCOUNT_H
+
+#include <stdbool.h>
+#include "threads/synch.h"
+
+/* Sequence counter.
+
+   A sequence counter lets readers read data that is too big to
+   load atomically, such as an int64_t on the 80x86, without
+   turning interrupts off or taking a lock.  The writer bumps the
+   counter before and after each update, so that it is odd while
+   an update is in progress.  A reader notes the counter before
+   reading and tries again if it was odd or changed meanwhile:
+
+        unsigned seq;
+        do
+          {
+            seq = seqcount_read_begin (&sc);
+            ...copy the data...
+          }
+        while (seqcount_read_retry (&sc, seq));
+
+   Writers must run with interrupts off, so that they are never
+   interrupted by a reader that would spin waiting for them, and
+   must exclude each other by some other means. */
+struct seqcount
+  {
+    volatile unsigned seq;      /* Odd while a write is in progress. */
+  };
+
+/* Initializes SC. */
+static inline void
+seqcount_init (struct seqcount *sc)
+{
+  sc->seq = 0;
+}
+
+/* Begins a read section of SC and returns the value to pass to
+   seqcount_read_retry() at its end. */
+static inline unsigned
+seqcount_read_begin (const struct seqcount *sc)
+{
+  unsigned seq;
+
+  do
+    {
+      seq = sc->seq;
+      barrier ();
+    }
+  while (seq & 1);
+  return seq;
+}
+
+/* Ends a read section of SC that began with SEQ.  Returns true
+   if a write intervened, so that the read must be retried. */
+static inline bool
+seqcount_read_retry (const struct seqcount *sc, unsigned seq)
+{
+  barrier ();
+  return sc->seq != seq;
+}
+
+/* Begins a write section of SC.  Interrupts must be off. */
+static inline void
+seqcount_write_begin (struct seqcount *sc)
+{
+  sc->seq++;
+  barrier ();
+}
+
+/* Ends a write section of SC. */
+static inline void
+seqcount_write_end (struct seqcount *sc)
+{
+  barrier ();
+  sc->seq++;
+}
+
+#endif /* threads/seqcount.h */
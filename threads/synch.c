@@ -31,6 +31,20 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "devices/timer.h"
+
+/* If false (default), lockstats are not updated.
+   Controlled by kernel command-line option "-lockstat". */
+bool lockstat_enabled;
+
+/* List of all registered lockstats. */
+static struct list lockstat_list = LIST_INITIALIZER (lockstat_list);
+
+static void lockstat_init (struct lockstat *, const char *name);
+static void lockstat_acquired (struct lockstat *, bool contended,
+                               int64_t start);
+static void lockstat_held (struct lockstat *);
+static void lockstat_released (struct lockstat *);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -102,7 +116,9 @@ sema_try_down (struct semaphore *sema)
 }
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
-   and wakes up one thread of those waiting for SEMA, if any.
+   and wakes up the highest-priority thread of those waiting for
+   SEMA, if any, yielding to it if it has higher priority than the
+   running thread.
 
    This function may be called from an interrupt handler. */
 void
@@ -114,15 +130,16 @@ sema_up (struct semaphore *sema)
 
   old_level = intr_disable ();
   if (!list_empty (&sema->waiters))
-  {
-    list_sort (&sema->waiters, thread_check_priority, NULL);
-    thread_unblock (list_entry (list_pop_front (&sema->waiters),
-                                struct thread, elem));
-  }
+    {
+      struct list_elem *e = list_max (&sema->waiters,
+                                      thread_priority_less, NULL);
+      list_remove (e);
+      thread_unblock (list_entry (e, struct thread, elem));
+    }
   sema->value++;
   intr_set_level (old_level);
 
-  thread_yield();
+  thread_preempt ();
 }
 
 static void sema_test_helper (void *sema_);
@@ -184,11 +201,24 @@ lock_init (struct lock *lock)
 
   lock->holder = NULL;
   sema_init (&lock->semaphore, 1);
+  lock->stat = NULL;
+}
+
+/* Starts keeping contention statistics for LOCK in ST, under the
+   given NAME, for printing at shutdown.  ST must stay allocated
+   as long as the kernel runs, so it is normally static. */
+void
+lock_profile (struct lock *lock, struct lockstat *st, const char *name)
+{
+  ASSERT (lock != NULL);
+
+  lockstat_init (st, name);
+  lock->stat = st;
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
-   thread.
+   thread.  While we wait, our priority is donated to the holder.
 
    This function may sleep, so it must not be called within an
    interrupt handler.  This function may be called with
@@ -197,12 +227,28 @@ lock_init (struct lock *lock)
 void
 lock_acquire (struct lock *lock)
 {
+  enum intr_level old_level;
+  bool contended;
+  int64_t start = 0;
+
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
+  contended = lock->holder != NULL;
+  if (contended)
+    {
+      if (lock->stat != NULL && lockstat_enabled)
+        start = timer_ticks ();
+      thread_donate_priority (lock);
+    }
   sema_down (&lock->semaphore);
+  thread_current ()->wait_on_lock = NULL;
   lock->holder = thread_current ();
+  lockstat_acquired (lock->stat, contended, start);
+  lockstat_held (lock->stat);
+  intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -221,11 +267,16 @@ lock_try_acquire (struct lock *lock)
 
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+      lock->holder = thread_current ();
+      lockstat_acquired (lock->stat, false, 0);
+      lockstat_held (lock->stat);
+    }
   return success;
 }
 
 /* Releases LOCK, which must be owned by the current thread.
+   Priority donated by threads waiting for LOCK is given back.
 
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to release a lock within an interrupt
@@ -233,11 +284,17 @@ lock_try_acquire (struct lock *lock)
 void
 lock_release (struct lock *lock) 
 {
+  enum intr_level old_level;
+
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
+  lockstat_released (lock->stat);
+  thread_remove_donations (lock);
   lock->holder = NULL;
   sema_up (&lock->semaphore);
+  intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -251,13 +308,312 @@ lock_held_by_current_thread (const struct lock *lock)
   return lock->holder == thread_current ();
 }
 
+/* Initializes RW as a readers-writer lock.  Any number of
+   threads may hold a readers-writer lock for reading at once,
+   but a thread that holds it for writing excludes all others.
+
+   Writers are preferred: a thread that wants to read waits while
+   a writer of equal or higher priority is waiting, so a steady
+   stream of readers cannot starve writers.  A waiting reader
+   with strictly higher priority than every waiting writer goes
+   first, though.  The lock is handed directly to the threads it
+   wakes, so newly arriving threads cannot barge in ahead of
+   them.  Unlike struct lock, readers-writer locks do not donate
+   priority. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  rw->readers = 0;
+  rw->writer = NULL;
+  list_init (&rw->read_waiters);
+  list_init (&rw->write_waiters);
+  rw->stat = NULL;
+}
+
+/* Starts keeping contention statistics for RW in ST, under the
+   given NAME.  See lock_profile(). */
+void
+rwlock_profile (struct rwlock *rw, struct lockstat *st, const char *name)
+{
+  ASSERT (rw != NULL);
+
+  lockstat_init (st, name);
+  rw->stat = st;
+}
+
+/* Returns the highest-priority thread in LIST, which must
+   contain threads through their `elem' members, or a null
+   pointer if LIST is empty. */
+static struct thread *
+max_waiter (struct list *list)
+{
+  if (list_empty (list))
+    return NULL;
+  return list_entry (list_max (list, thread_priority_less, NULL),
+                     struct thread, elem);
+}
+
+/* Hands RW, which has just become free, to the threads that
+   should have it next, and wakes them up.  Interrupts must be
+   off. */
+static void
+rwlock_wake (struct rwlock *rw)
+{
+  struct thread *writer = max_waiter (&rw->write_waiters);
+  struct thread *reader = max_waiter (&rw->read_waiters);
+  struct list_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (rw->readers == 0 && rw->writer == NULL);
+
+  if (writer != NULL || reader != NULL)
+    lockstat_held (rw->stat);
+  if (writer != NULL && (reader == NULL || reader->priority <= writer->priority))
+    {
+      list_remove (&writer->elem);
+      rw->writer = writer;
+      thread_unblock (writer);
+      return;
+    }
+
+  /* Wake the readers that need not defer to a waiting writer. */
+  for (e = list_begin (&rw->read_waiters); e != list_end (&rw->read_waiters); )
+    {
+      struct thread *t = list_entry (e, struct thread, elem);
+      if (writer == NULL || t->priority > writer->priority)
+        {
+          e = list_remove (e);
+          rw->readers++;
+          thread_unblock (t);
+        }
+      else
+        e = list_next (e);
+    }
+}
+
+/* Acquires RW for reading, sleeping until no writer holds it or
+   is waiting for it with equal or higher priority.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  struct thread *writer;
+  enum intr_level old_level;
+  bool contended;
+  int64_t start = 0;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rw->writer != cur);
+
+  old_level = intr_disable ();
+  writer = max_waiter (&rw->write_waiters);
+  contended = (rw->writer != NULL
+               || (writer != NULL && writer->priority >= cur->priority));
+  if (contended)
+    {
+      /* Whoever releases the lock counts us as a reader. */
+      if (rw->stat != NULL && lockstat_enabled)
+        start = timer_ticks ();
+      list_push_back (&rw->read_waiters, &cur->elem);
+      thread_block ();
+    }
+  else if (rw->readers++ == 0)
+    lockstat_held (rw->stat);
+  lockstat_acquired (rw->stat, contended, start);
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void
+rwlock_release_read (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (rw->readers > 0);
+
+  old_level = intr_disable ();
+  if (--rw->readers == 0)
+    {
+      lockstat_released (rw->stat);
+      rwlock_wake (rw);
+    }
+  intr_set_level (old_level);
+
+  thread_preempt ();
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  bool contended;
+  int64_t start = 0;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rw->writer != cur);
+
+  old_level = intr_disable ();
+  contended = rw->writer != NULL || rw->readers > 0;
+  if (contended)
+    {
+      /* Whoever releases the lock makes us the writer. */
+      if (rw->stat != NULL && lockstat_enabled)
+        start = timer_ticks ();
+      list_push_back (&rw->write_waiters, &cur->elem);
+      thread_block ();
+    }
+  else
+    {
+      rw->writer = cur;
+      lockstat_held (rw->stat);
+    }
+  ASSERT (rw->writer == cur);
+  lockstat_acquired (rw->stat, contended, start);
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void
+rwlock_release_write (struct rwlock *rw)
+{
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (rwlock_held_by_current_thread (rw));
+
+  old_level = intr_disable ();
+  lockstat_released (rw->stat);
+  rw->writer = NULL;
+  rwlock_wake (rw);
+  intr_set_level (old_level);
+
+  thread_preempt ();
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise. */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  return rw->writer == thread_current ();
+}
+
+/* Initializes ST to keep statistics under NAME and adds it to the
+   list printed by lockstat_print_stats(). */
+static void
+lockstat_init (struct lockstat *st, const char *name)
+{
+  enum intr_level old_level;
+
+  ASSERT (st != NULL);
+  ASSERT (name != NULL);
+
+  st->name = name;
+  st->acquire_cnt = st->contended_cnt = st->wait_ticks = 0;
+  st->hold_max = st->acquired_at = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&lockstat_list, &st->elem);
+  intr_set_level (old_level);
+}
+
+/* Records in ST, if non-null, that its lock was just acquired.
+   If CONTENDED, the acquiring thread had to wait since tick
+   START. */
+static void
+lockstat_acquired (struct lockstat *st, bool contended, int64_t start)
+{
+  if (st == NULL || !lockstat_enabled)
+    return;
+
+  st->acquire_cnt++;
+  if (contended)
+    {
+      st->contended_cnt++;
+      st->wait_ticks += timer_ticks () - start;
+    }
+}
+
+/* Records in ST, if non-null, that its lock just went from free
+   to held. */
+static void
+lockstat_held (struct lockstat *st)
+{
+  if (st == NULL || !lockstat_enabled)
+    return;
+
+  st->acquired_at = timer_ticks ();
+}
+
+/* Records in ST, if non-null, that its lock is going from held
+   to free. */
+static void
+lockstat_released (struct lockstat *st)
+{
+  int64_t held;
+
+  if (st == NULL || !lockstat_enabled)
+    return;
+
+  held = timer_ticks () - st->acquired_at;
+  if (held > st->hold_max)
+    st->hold_max = held;
+}
+
+/* Prints the statistics of all profiled locks, if enabled. */
+void
+lockstat_print_stats (void)
+{
+  struct list_elem *e;
+
+  if (!lockstat_enabled)
+    return;
+
+  for (e = list_begin (&lockstat_list); e != list_end (&lockstat_list);
+       e = list_next (e))
+    {
+      struct lockstat *st = list_entry (e, struct lockstat, elem);
+      printf ("Lock %s: %lld acquisitions, %lld contended, "
+              "%lld ticks waiting, %lld ticks max hold\n",
+              st->name, st->acquire_cnt, st->contended_cnt,
+              st->wait_ticks, st->hold_max);
+    }
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem 
   {
     struct list_elem elem;              /* List element. */
     struct semaphore semaphore;         /* This semaphore. */
+    struct thread *thread;              /* Thread waiting on it. */
   };
 
+/* Returns true if the thread waiting on semaphore_elem A has
+   lower priority than the one waiting on B. */
+static bool
+waiter_priority_less (const struct list_elem *a, const struct list_elem *b,
+                      void *aux UNUSED)
+{
+  return (list_entry (a, struct semaphore_elem, elem)->thread->priority
+          < list_entry (b, struct semaphore_elem, elem)->thread->priority);
+}
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -300,6 +656,7 @@ cond_wait (struct condition *cond, struct lock *lock)
   ASSERT (lock_held_by_current_thread (lock));
   
   sema_init (&waiter.semaphore, 0);
+  waiter.thread = thread_current ();
   list_push_back (&cond->waiters, &waiter.elem);
   lock_release (lock);
   sema_down (&waiter.semaphore);
@@ -307,7 +664,8 @@ cond_wait (struct condition *cond, struct lock *lock)
 }
 
 /* If any threads are waiting on COND (protected by LOCK), then
-   this function signals one of them to wake up from its wait.
+   this function signals the highest-priority one of them to wake
+   up from its wait.
    LOCK must be held before calling this function.
 
    An interrupt handler cannot acquire a lock, so it does not
@@ -322,8 +680,12 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED)
   ASSERT (lock_held_by_current_thread (lock));
 
   if (!list_empty (&cond->waiters)) 
-    sema_up (&list_entry (list_pop_front (&cond->waiters),
-                          struct semaphore_elem, elem)->semaphore);
+    {
+      struct list_elem *e = list_max (&cond->waiters,
+                                      waiter_priority_less, NULL);
+      list_remove (e);
+      sema_up (&list_entry (e, struct semaphore_elem, elem)->semaphore);
+    }
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore 
@@ -17,19 +18,59 @@ bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
+/* Lock contention statistics.  Kept only for locks registered
+   with lock_profile() or rwlock_profile(), and only if
+   lockstat_enabled is true.  Times are in timer ticks. */
+struct lockstat
+  {
+    const char *name;           /* Name of lock. */
+    struct list_elem elem;      /* Element in list of all lockstats. */
+    long long acquire_cnt;      /* # of acquisitions. */
+    long long contended_cnt;    /* # of acquisitions that had to wait. */
+    long long wait_ticks;       /* Total ticks spent waiting. */
+    int64_t hold_max;           /* Longest time held. */
+    int64_t acquired_at;        /* When the lock was last acquired. */
+  };
+
+/* If false (default), lockstats are not updated.
+   Controlled by kernel command-line option "-lockstat". */
+extern bool lockstat_enabled;
+
+void lockstat_print_stats (void);
+
 /* Lock. */
 struct lock 
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    struct lockstat *stat;      /* Contention statistics, or null. */
   };
 
 void lock_init (struct lock *);
+void lock_profile (struct lock *, struct lockstat *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Readers-writer lock. */
+struct rwlock
+  {
+    unsigned readers;           /* # of threads holding it to read. */
+    struct thread *writer;      /* Thread holding it to write, or null. */
+    struct list read_waiters;   /* Threads waiting to read. */
+    struct list write_waiters;  /* Threads waiting to write. */
+    struct lockstat *stat;      /* Contention statistics, or null. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_profile (struct rwlock *, struct lockstat *, const char *name);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+
 /* Condition variable. */
 struct condition 
   {
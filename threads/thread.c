@@ -12,6 +12,7 @@
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "threads/real.c"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -21,15 +22,34 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Run queue of processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running.
+   There is one FIFO list per priority level.  Bit N of
+   ready_mask is set if and only if ready_queues[N] is nonempty,
+   so both enqueueing a thread and finding the highest-priority
+   ready thread take constant time.
+
+   Under the stride scheduler, the run queue is instead a heap
+   ordered by pass value, stride_heap, and the per-priority lists
+   are unused.
+
+   Ready threads in the real-time class wait in rt_heap instead,
+   ordered by absolute deadline, and always run before any other
+   ready thread. */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static struct heap stride_heap;
+static struct heap rt_heap;
+static size_t ready_cnt;        /* # of threads in THREAD_READY state. */
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
 static struct list all_list;
 
-static struct list block_list;
+/* Sleep queue: threads blocked in thread_sleep(), ordered by
+   wakeup tick so that the timer interrupt only has to look at
+   the threads that are actually due. */
+static struct heap sleep_heap;
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -39,6 +59,7 @@ static struct thread *initial_thread;
 
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
+static struct lockstat tid_lockstat;
 
 /* Stack frame for kernel_thread(). */
 struct kernel_thread_frame 
@@ -55,6 +76,7 @@ static long long user_ticks;    /* # of timer ticks in user programs. */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
+#define DONATION_DEPTH_MAX 8    /* Max length of a donation chain. */
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
 #ifndef USERPROG
@@ -62,11 +84,53 @@ bool thread_prior_aging;
 #endif
 int load_avg;
 
+/* Multi-level feedback queue scheduler state.  The per-second
+   decay of recent_cpu is applied lazily: decay_history[N %
+   DECAY_HISTORY_CNT] holds the coefficient used at the end of
+   second N, and each thread's mlfqs_epoch records how many of
+   those decays its recent_cpu already reflects. */
+#define DECAY_HISTORY_CNT 256   /* # of past decay coefficients kept. */
+#define STALE_REFRESH_CNT 8     /* Max stale ready threads refreshed per tick. */
+static unsigned mlfqs_epoch;    /* # of seconds elapsed. */
+static int decay_history[DECAY_HISTORY_CNT];
+static uint64_t stale_mask;     /* Run queues that may hold stale threads. */
+
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use the stride scheduler, which divides the CPU
+   among threads in proportion to their tickets, regardless of
+   priority.  Controlled by kernel command-line option
+   "-stride". */
+bool thread_stride;
+
+/* Stride scheduler state.  Each thread's pass advances by its
+   stride, which is inversely proportional to its tickets, for
+   every tick it runs, and the ready thread with the lowest pass
+   runs next.  stride_pass is the pass of the thread dispatched
+   most recently; a thread that has been blocked is moved up to
+   it so that it cannot claim the time it spent blocked. */
+#define STRIDE_LARGE (1 << 20)  /* Stride of a thread with one ticket. */
+static int64_t stride_pass;
+
+/* Real-time class.  A thread in it runs for at most rt_runtime
+   ticks in each period of rt_period ticks, by a deadline
+   rt_deadline ticks after the period starts.  Ready real-time
+   threads run earliest deadline first, ahead of every other
+   thread.  A thread that uses up its runtime is throttled: it
+   sleeps until its next period begins.
+
+   Admission control keeps the sum of the densities
+   rt_runtime / rt_deadline of all real-time threads, kept as
+   fractions of RT_BW_ONE, at or below RT_BW_MAX.  EDF meets
+   every deadline of such a set, and the rest of the CPU is left
+   for ordinary threads. */
+#define RT_BW_ONE (1 << 20)             /* Whole CPU. */
+#define RT_BW_MAX (RT_BW_ONE / 100 * 95) /* Most the class may use. */
+static int64_t rt_bw_total;             /* Sum of admitted densities. */
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -78,6 +142,17 @@ static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
+static void ready_queue_push (struct thread *);
+static void ready_queue_remove (struct thread *);
+static struct thread *ready_queue_pop (void);
+static int ready_queue_max_priority (void);
+static bool ready_queue_outranks (const struct thread *);
+static void rt_replenish (struct thread *, int64_t now);
+static void mlfqs_refresh (struct thread *);
+static heap_less_func waketime_less;
+static heap_less_func pass_less;
+static heap_less_func deadline_less;
+static void account_switch (struct thread *);
 
 /* Initializes the threading system by transforming the code
    that's currently running into a thread.  This can't work in
@@ -95,12 +170,20 @@ static tid_t allocate_tid (void);
 void
 thread_init (void) 
 {
+  int i;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
-  list_init (&ready_list);
+  lock_profile (&tid_lock, &tid_lockstat, "tid");
+  for (i = PRI_MIN; i <= PRI_MAX; i++)
+    list_init (&ready_queues[i]);
+  ready_mask = 0;
+  heap_init (&stride_heap, pass_less, NULL);
+  heap_init (&rt_heap, deadline_less, NULL);
+  ready_cnt = 0;
   list_init (&all_list);
-  list_init (&block_list);
+  heap_init (&sleep_heap, waketime_less, NULL);
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
@@ -146,9 +229,28 @@ thread_tick (void)
   else
     kernel_ticks++;
 
-  /* Enforce preemption. */
-  if (++thread_ticks >= TIME_SLICE)
-    intr_yield_on_return ();
+  t->stat.run_ticks++;
+  if (thread_stride && t != idle_thread)
+    t->pass += t->stride;
+
+  /* Enforce the real-time budget.  A real-time thread is not
+     time-sliced; it runs until it blocks, is preempted by an
+     earlier deadline, or runs out of budget. */
+  if (thread_is_rt (t))
+    {
+      ++thread_ticks;
+      if (--t->rt_budget <= 0)
+        {
+          t->rt_throttled = true;
+          t->preempted = true;
+          intr_yield_on_return ();
+        }
+    }
+  else if (++thread_ticks >= TIME_SLICE)
+    {
+      t->preempted = true;
+      intr_yield_on_return ();
+    }
 
 #ifndef USERPROG
   if (thread_prior_aging == true)
@@ -162,12 +264,33 @@ thread_aging (void)
   return;
 }
 
-/* Prints thread statistics. */
+/* Prints thread statistics, including the scheduler statistics
+   of each thread that still exists. */
 void
 thread_print_stats (void) 
 {
+  enum intr_level old_level;
+  struct list_elem *e;
+
   printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
           idle_ticks, kernel_ticks, user_ticks);
+
+  old_level = intr_disable ();
+  for (e = list_begin (&all_list); e != list_end (&all_list);
+       e = list_next (e))
+    {
+      struct thread *t = list_entry (e, struct thread, allelem);
+      const struct schedstat *st = &t->stat;
+
+      printf ("Thread %d (%s): %lld run ticks, %lld wait ticks, "
+              "%u voluntary and %u involuntary switches, "
+              "%u wakeups (%lld ticks max latency), "
+              "%lld ticks max overrun\n",
+              t->tid, t->name, st->run_ticks, st->wait_ticks,
+              (unsigned) st->voluntary_cnt, (unsigned) st->involuntary_cnt,
+              (unsigned) st->wakeup_cnt, st->wakeup_max, st->overrun_max);
+    }
+  intr_set_level (old_level);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -223,11 +346,7 @@ thread_create (const char *name, int priority,
 
   /* Add to run queue. */
   thread_unblock (t);
-
-  if (thread_get_priority() < priority)
-  {
-    thread_yield();
-  }
+  thread_preempt ();
 
   return tid;
 }
@@ -265,8 +384,15 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
-  //list_push_back (&ready_list, &t->elem);
-  list_insert_ordered(&ready_list, &t->elem, thread_check_priority, NULL);
+  t->ready_since = timer_ticks ();
+  t->woken = true;
+  if (thread_mlfqs)
+    mlfqs_refresh (t);
+  if (thread_stride && t->pass < stride_pass)
+    t->pass = stride_pass;
+  if (thread_is_rt (t))
+    rt_replenish (t, t->ready_since);
+  ready_queue_push (t);
   t->status = THREAD_READY;
   intr_set_level (old_level);
 }
@@ -319,6 +445,7 @@ thread_exit (void)
      and schedule another process.  That process will destroy us
      when it calls thread_schedule_tail(). */
   intr_disable ();
+  rt_bw_total -= thread_current ()->rt_bw;
   list_remove (&thread_current()->allelem);
   thread_current ()->status = THREAD_DYING;
   schedule ();
@@ -326,7 +453,9 @@ thread_exit (void)
 }
 
 /* Yields the CPU.  The current thread is not put to sleep and
-   may be scheduled again immediately at the scheduler's whim. */
+   may be scheduled again immediately at the scheduler's whim.
+   A throttled real-time thread instead sleeps until its next
+   period begins. */
 void
 thread_yield (void) 
 {
@@ -336,21 +465,163 @@ thread_yield (void)
   ASSERT (!intr_context ());
 
   old_level = intr_disable ();
+  if (cur->rt_throttled)
+    {
+      cur->waketime = cur->rt_next_period;
+      heap_push (&sleep_heap, &cur->sleep_elem);
+      thread_block ();
+      intr_set_level (old_level);
+      return;
+    }
   if (cur != idle_thread) 
-    //list_push_back (&ready_list, &cur->elem);
-    list_insert_ordered(&ready_list, &cur->elem, thread_check_priority, NULL);
+    {
+      if (thread_mlfqs)
+        mlfqs_refresh (cur);
+      ready_queue_push (cur);
+    }
   cur->status = THREAD_READY;
   schedule ();
   intr_set_level (old_level);
 }
 
-/* check priority between this and check. if this elem is higher priority, return true, else false.*/
+/* Yields the CPU if a ready thread has a higher priority than
+   the running thread.  In an interrupt handler, arranges to
+   yield just before the interrupt returns instead. */
+void
+thread_preempt (void)
+{
+  enum intr_level old_level;
+  bool preempted;
+
+  old_level = intr_disable ();
+  preempted = ready_queue_outranks (thread_current ());
+  if (preempted)
+    thread_current ()->preempted = true;
+  intr_set_level (old_level);
+
+  if (!preempted)
+    return;
+  if (intr_context ())
+    intr_yield_on_return ();
+  else
+    thread_yield ();
+}
+
+/* Returns true if the thread that contains list element A,
+   through its `elem' member, has lower priority than the one
+   that contains B. */
 bool
-thread_check_priority (struct list_elem *this, struct list_elem *check, void *aux UNUSED)
+thread_priority_less (const struct list_elem *a, const struct list_elem *b,
+                      void *aux UNUSED)
 {
-  return list_entry (this, struct thread, elem)->priority > list_entry (check, struct thread, elem)->priority;
+  return (list_entry (a, struct thread, elem)->priority
+          < list_entry (b, struct thread, elem)->priority);
 }
 
+/* Sets T's effective priority to PRIORITY, moving T to the run
+   queue for its new priority if it is ready.  Interrupts must be
+   off. */
+static void
+set_effective_priority (struct thread *t, int priority)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t->priority == priority)
+    return;
+  if (t->status == THREAD_READY)
+    {
+      ready_queue_remove (t);
+      t->priority = priority;
+      ready_queue_push (t);
+    }
+  else
+    t->priority = priority;
+}
+
+/* Recomputes T's effective priority as the higher of its base
+   priority and the priorities donated to it.  Interrupts must be
+   off. */
+static void
+refresh_priority (struct thread *t)
+{
+  int priority = t->base_priority;
+  struct list_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (e = list_begin (&t->donations); e != list_end (&t->donations);
+       e = list_next (e))
+    {
+      struct thread *donor = list_entry (e, struct thread, donation_elem);
+      if (donor->priority > priority)
+        priority = donor->priority;
+    }
+  set_effective_priority (t, priority);
+}
+
+/* Records that the running thread is about to wait for LOCK,
+   which is held by another thread, and donates its priority to
+   the holder.  If the holder is itself waiting for a lock, the
+   donation is passed along, up to DONATION_DEPTH_MAX levels deep
+   so that a cycle cannot hang the kernel.  Does nothing under
+   the MLFQS, which does not use donation.  Interrupts must be
+   off. */
+void
+thread_donate_priority (struct lock *lock)
+{
+  struct thread *t = thread_current ();
+  int depth;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (lock->holder != NULL);
+
+  if (thread_mlfqs)
+    return;
+
+  t->wait_on_lock = lock;
+  list_push_back (&lock->holder->donations, &t->donation_elem);
+
+  for (depth = 0; depth < DONATION_DEPTH_MAX; depth++)
+    {
+      struct thread *holder;
+
+      if (t->wait_on_lock == NULL)
+        break;
+      holder = t->wait_on_lock->holder;
+      if (holder == NULL || holder->priority >= t->priority)
+        break;
+      set_effective_priority (holder, t->priority);
+      t = holder;
+    }
+}
+
+/* Withdraws the donations that the threads waiting for LOCK made
+   to the running thread, which is about to release LOCK, and
+   drops its priority accordingly.  Interrupts must be off. */
+void
+thread_remove_donations (struct lock *lock)
+{
+  struct thread *cur = thread_current ();
+  struct list_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (thread_mlfqs)
+    return;
+
+  for (e = list_begin (&cur->donations); e != list_end (&cur->donations); )
+    {
+      struct thread *donor = list_entry (e, struct thread, donation_elem);
+      if (donor->wait_on_lock == lock)
+        e = list_remove (e);
+      else
+        e = list_next (e);
+    }
+  refresh_priority (cur);
+}
+
+/* Puts the current thread to sleep until the timer reaches
+   tick TICKS. */
 void
 thread_sleep (int64_t ticks)
 {
@@ -362,28 +633,43 @@ thread_sleep (int64_t ticks)
 
   old_level = intr_disable ();
   cur->waketime = ticks;
-  list_push_back(&block_list, &cur->elem);
-  thread_block();
+  heap_push (&sleep_heap, &cur->sleep_elem);
+  thread_block ();
   intr_set_level (old_level);
 }
 
+/* Wakes up every sleeping thread whose wakeup tick is TICKS or
+   earlier.  Only the threads that are due are touched, so when
+   nothing expires this takes constant time.  Interrupts must be
+   off. */
 void
 thread_wake (int64_t ticks)
 {
-  struct list_elem *e;
-  for (e = list_begin (&block_list); e != list_end (&block_list);)
-  {
-    struct thread *t = list_entry (e, struct thread, elem);
-    if(ticks >= t->waketime)
-    {
-      e = list_remove(e);
-      thread_unblock(t);
-    }
-    else
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  while (!heap_empty (&sleep_heap))
     {
-      e = list_next(e);
+      struct thread *t = heap_entry (heap_top (&sleep_heap),
+                                     struct thread, sleep_elem);
+      if (t->waketime > ticks)
+        break;
+      heap_pop (&sleep_heap);
+      thread_unblock (t);
     }
-  }
+}
+
+/* Returns the tick at which the next sleeping thread is due to
+   wake up, or INT64_MAX if no thread is sleeping.  Interrupts
+   must be off. */
+int64_t
+thread_next_wakeup (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (heap_empty (&sleep_heap))
+    return INT64_MAX;
+  return heap_entry (heap_top (&sleep_heap), struct thread,
+                     sleep_elem)->waketime;
 }
 
 /* Invoke function 'func' on all threads, passing along 'aux'.
@@ -407,14 +693,21 @@ thread_foreach (thread_action_func *func, void *aux)
 void
 thread_set_priority (int new_priority) 
 {
-  if (!thread_mlfqs){
-    int prev_priority = thread_current ()->priority;
-    thread_current ()->priority = new_priority;
-    if (new_priority < prev_priority)
-    {
-      thread_yield();
-    }
-  }
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+
+  if (thread_mlfqs)
+    return;
+
+  /* The effective priority becomes the higher of the new base
+     priority and any priority still donated to us, so lowering
+     the base priority does not undo a donation. */
+  old_level = intr_disable ();
+  cur->base_priority = new_priority;
+  refresh_priority (cur);
+  intr_set_level (old_level);
+
+  thread_preempt ();
 }
 
 /* Returns the current thread's priority. */
@@ -428,8 +721,25 @@ thread_get_priority (void)
 void
 thread_set_nice (int nice) 
 {
-  thread_current ()->nice = nice;
-  thread_set_priority(thread_current()->priority + nice);
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  bool preempted;
+
+  cur->nice = nice;
+  if (!thread_mlfqs)
+    {
+      thread_set_priority(cur->priority + nice);
+      return;
+    }
+
+  /* Recompute our priority and give way if we are no longer the
+     highest-priority thread. */
+  old_level = intr_disable ();
+  calc_priority (cur);
+  preempted = ready_queue_outranks (cur);
+  intr_set_level (old_level);
+  if (preempted)
+    thread_yield ();
 }
 
 /* Returns the current thread's nice value. */
@@ -439,6 +749,119 @@ thread_get_nice (void)
   return thread_current ()->nice;
 }
 
+/* Starts a new job for real-time thread T if its next period
+   has begun by tick NOW: the budget is refilled and the deadline
+   moves to RT_DEADLINE ticks from now.  A thread woken within
+   its period keeps the budget and deadline it had. */
+static void
+rt_replenish (struct thread *t, int64_t now)
+{
+  if (now < t->rt_next_period)
+    return;
+  t->rt_budget = t->rt_runtime;
+  t->rt_abs_deadline = now + t->rt_deadline;
+  t->rt_next_period = now + t->rt_period;
+  t->rt_throttled = false;
+}
+
+/* Moves the current thread into the real-time class, to run for
+   up to RUNTIME ticks of every PERIOD ticks, each time by a
+   deadline DEADLINE ticks after the period begins.  The thread
+   starts its first period immediately.  If the thread is already
+   in the class, its parameters are replaced.  A RUNTIME of 0
+   returns the thread to the scheduling class it was in before.
+
+   Returns false, leaving the thread's class unchanged, if the
+   parameters do not satisfy 0 < RUNTIME <= DEADLINE <= PERIOD or
+   if admitting the thread would leave the real-time threads
+   unable to meet their deadlines. */
+bool
+thread_set_deadline (int64_t runtime, int64_t deadline, int64_t period)
+{
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  int64_t bw = 0;
+
+  if (runtime != 0)
+    {
+      if (runtime < 0 || runtime > deadline || deadline > period)
+        return false;
+      bw = runtime * RT_BW_ONE / deadline;
+    }
+
+  old_level = intr_disable ();
+  if (rt_bw_total - cur->rt_bw + bw > RT_BW_MAX)
+    {
+      intr_set_level (old_level);
+      return false;
+    }
+  rt_bw_total += bw - cur->rt_bw;
+  cur->rt_bw = bw;
+  cur->rt_runtime = runtime;
+  cur->rt_deadline = deadline;
+  cur->rt_period = period;
+  cur->rt_throttled = false;
+  if (runtime != 0)
+    {
+      cur->rt_next_period = 0;
+      rt_replenish (cur, timer_ticks ());
+    }
+  intr_set_level (old_level);
+
+  thread_preempt ();
+  return true;
+}
+
+/* Sets the current thread's number of stride scheduler tickets
+   to TICKETS.  Returns true if successful, false if TICKETS is
+   out of range. */
+bool
+thread_set_tickets (int tickets)
+{
+  struct thread *cur = thread_current ();
+
+  if (tickets < 1 || tickets > THREAD_MAX_TICKETS)
+    return false;
+  cur->tickets = tickets;
+  cur->stride = STRIDE_LARGE / tickets;
+  return true;
+}
+
+/* Returns the current thread's number of stride scheduler
+   tickets. */
+int
+thread_get_tickets (void)
+{
+  return thread_current ()->tickets;
+}
+
+/* Copies the scheduler statistics of the thread with the given
+   TID into *ST.  Returns true if successful, false if there is no
+   such thread. */
+bool
+thread_get_schedstat (tid_t tid, struct schedstat *st)
+{
+  enum intr_level old_level;
+  struct list_elem *e;
+  bool found = false;
+
+  old_level = intr_disable ();
+  for (e = list_begin (&all_list); e != list_end (&all_list);
+       e = list_next (e))
+    {
+      struct thread *t = list_entry (e, struct thread, allelem);
+      if (t->tid == tid)
+        {
+          *st = t->stat;
+          found = true;
+          break;
+        }
+    }
+  intr_set_level (old_level);
+
+  return found;
+}
+
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) 
@@ -453,70 +876,176 @@ thread_get_recent_cpu (void)
   return float_to_int_near(mul_comb(thread_current()->recent_cpu,100));
 }
 
+/* Returns the priority that the MLFQS formula gives T for its
+   current recent_cpu and nice values. */
+static int
+mlfqs_priority (const struct thread *t)
+{
+  int priority = PRI_MAX - float_to_int_zero(add_comb(div_comb(t->recent_cpu,4),t->nice*2));
+  if (priority < PRI_MIN)
+    priority = PRI_MIN;
+  else if (priority > PRI_MAX)
+    priority = PRI_MAX;
+  return priority;
+}
+
 void
 calc_priority (struct thread *t)
 {
   if (t != idle_thread){
-    t->priority = PRI_MAX - float_to_int_zero(add_comb(div_comb(t->recent_cpu,4),t->nice*2));
+    int priority = mlfqs_priority (t);
+
+    /* A ready thread has to move to the queue for its new
+       priority. */
+    if (t->status == THREAD_READY && t->priority != priority)
+      {
+        ready_queue_remove (t);
+        t->priority = priority;
+        ready_queue_push (t);
+      }
+    else
+      t->priority = priority;
   }
 }
 
+/* Brings T's recent_cpu up to date by applying the per-second
+   decays that happened since it was last brought up to date.
+   This gives exactly the value that decaying T once every second
+   would have, because nothing else changes a thread's recent_cpu
+   while it is not running. */
 void
 calc_recent_cpu (struct thread *t)
 {
+  unsigned missed = mlfqs_epoch - t->mlfqs_epoch;
+  unsigned epoch;
+
   if (t != idle_thread){
-    t->recent_cpu = add_comb(mul_float(div_float(mul_comb(load_avg,2),add_comb(mul_comb(load_avg,2),1)),t->recent_cpu),t->nice);
+    /* Older decays than we have kept have long since scaled the
+       old value down to nothing. */
+    if (missed > DECAY_HISTORY_CNT)
+      missed = DECAY_HISTORY_CNT;
+    for (epoch = mlfqs_epoch - missed; epoch != mlfqs_epoch; epoch++)
+      t->recent_cpu = add_comb(mul_float(decay_history[epoch % DECAY_HISTORY_CNT],t->recent_cpu),t->nice);
   }
+  t->mlfqs_epoch = mlfqs_epoch;
 }
 
 void
 calc_load_avg (void)
 {
-  int ready_threads = list_size(&ready_list);
+  int ready_threads = ready_cnt;
   if(thread_current() != idle_thread){
     ready_threads += 1;
   }
   load_avg = add_float(mul_float(div_float(int_to_float(59),int_to_float(60)),load_avg),mul_comb(div_float(int_to_float(1),int_to_float(60)),ready_threads));
 }
 
-// update all threads' priority in every 4 ticks
-void update_priority(void)
+/* Brings T's recent_cpu and priority up to date.  Called for
+   each thread as it is put on the run queue, so that threads
+   that were blocked across one or more seconds pick up the decay
+   they missed. */
+static void
+mlfqs_refresh (struct thread *t)
 {
-  struct thread *t;
-  for(struct list_elem *e = list_begin(&all_list); e!= list_end(&all_list); e=list_next(e)){
-    t = list_entry(e, struct thread, allelem);
-    calc_priority(t);
-  }
+  calc_recent_cpu (t);
+  calc_priority (t);
 }
 
-// increase RUNNING state thread's recent_cpu by 1 in every tick
-void increase_recent_cpu(void)
+/* Refreshes up to STALE_REFRESH_CNT threads that have sat in the
+   run queue since before the last per-second decay.  Ready
+   threads that never run would otherwise keep the priority they
+   had when they were enqueued, and a low-priority thread could
+   starve even though its recent_cpu has long since decayed.
+
+   Within each queue the stale threads are always a prefix,
+   because a thread is refreshed whenever it is enqueued and a
+   refreshed thread goes to the back of its new queue.  Bit N of
+   stale_mask is set if ready_queues[N] may still have a stale
+   prefix.  The lowest priorities are refreshed first, since they
+   are the ones that can starve. */
+static void
+mlfqs_refresh_stale (void)
 {
-  if (thread_current() != idle_thread){
-    thread_current()->recent_cpu = add_comb(thread_current()->recent_cpu,1);
-  }
+  int budget = STALE_REFRESH_CNT;
+
+  while (stale_mask != 0 && budget-- > 0)
+    {
+      uint32_t low = stale_mask;
+      int priority = (low != 0 ? __builtin_ctz (low)
+                      : 32 + __builtin_ctz ((uint32_t) (stale_mask >> 32)));
+      struct list *queue = &ready_queues[priority];
+      struct thread *t;
+
+      if (list_empty (queue))
+        {
+          stale_mask &= ~((uint64_t) 1 << priority);
+          continue;
+        }
+      t = list_entry (list_front (queue), struct thread, elem);
+      if (t->mlfqs_epoch == mlfqs_epoch)
+        {
+          stale_mask &= ~((uint64_t) 1 << priority);
+          continue;
+        }
+
+      ready_queue_remove (t);
+      calc_recent_cpu (t);
+      t->priority = mlfqs_priority (t);
+      ready_queue_push (t);
+    }
 }
 
-// update all threads' recent_cpu in every 1 sec
-void update_recent_cpu(void)
+/* Does the multi-level feedback queue scheduler's bookkeeping
+   for timer tick TICKS.  Called by the timer interrupt handler.
+
+   Only the running thread is charged and reprioritized on each
+   tick.  At the end of each second, the decay coefficient is
+   recorded and load_avg is updated, but other threads' recent_cpu
+   is decayed only when they are next enqueued.  Apart from the
+   fixed budget spent on stale ready threads, none of this
+   depends on the number of threads. */
+void
+thread_mlfqs_tick (int64_t ticks)
 {
-  struct thread *t;
-  for(struct list_elem *e = list_begin(&all_list); e!= list_end(&all_list); e=list_next(e)){
-    t = list_entry(e, struct thread, allelem);
-    calc_recent_cpu(t);
-  }
+  struct thread *cur = thread_current ();
+
+  ASSERT (intr_context ());
+
+  if (cur != idle_thread)
+    cur->recent_cpu = add_comb(cur->recent_cpu,1);
+
+  if (ticks % 4 == 0)
+    {
+      calc_priority (cur);
+      if (ready_queue_outranks (cur))
+        {
+          cur->preempted = true;
+          intr_yield_on_return ();
+        }
+    }
+
+  if (ticks % TIMER_FREQ == 0)
+    {
+      decay_history[mlfqs_epoch % DECAY_HISTORY_CNT] = div_float(mul_comb(load_avg,2),add_comb(mul_comb(load_avg,2),1));
+      mlfqs_epoch++;
+      calc_load_avg ();
+      calc_recent_cpu (cur);
+      stale_mask = ready_mask;
+    }
+
+  mlfqs_refresh_stale ();
 }
 
-
+
 /* Idle thread.  Executes when no other thread is ready to run.
 
-   The idle thread is initially put on the ready list by
+   The idle thread is initially put on the run queue by
    thread_start().  It will be scheduled once initially, at which
    point it initializes idle_thread, "up"s the semaphore passed
    to it to enable thread_start() to continue, and immediately
    blocks.  After that, the idle thread never appears in the
-   ready list.  It is returned by next_thread_to_run() as a
-   special case when the ready list is empty. */
+   run queue.  It is returned by next_thread_to_run() as a
+   special case when the run queue is empty. */
 static void
 idle (void *idle_started_ UNUSED) 
 {
@@ -530,6 +1059,19 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
+      /* Nobody else can run.  Zero free pages ahead of time until
+         there is something to do. */
+      intr_enable ();
+      while (ready_cnt == 0 && palloc_prezero_page ())
+        continue;
+      intr_disable ();
+      if (ready_cnt != 0)
+        continue;
+
+      /* Stop the periodic tick until the next sleeping thread is
+         due, if so configured. */
+      timer_idle_enter ();
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -593,10 +1135,16 @@ init_thread (struct thread *t, const char *name, int priority)
   t->status = THREAD_BLOCKED;
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
-  t->priority = priority;
+  t->priority = t->base_priority = priority;
+  list_init (&t->donations);
   t->magic = THREAD_MAGIC;
   t->nice = running_thread()->nice;
   t->recent_cpu = running_thread()->recent_cpu;
+  t->mlfqs_epoch = mlfqs_epoch;
+  t->tickets = (t != running_thread () ? running_thread ()->tickets
+                : THREAD_DEFAULT_TICKETS);
+  t->stride = STRIDE_LARGE / t->tickets;
+  t->pass = stride_pass;
 
   old_level = intr_disable ();
   list_push_back (&all_list, &t->allelem);
@@ -606,13 +1154,14 @@ init_thread (struct thread *t, const char *name, int priority)
   #ifdef USERPROG
     t->failed=0;
     t->parent = running_thread();
-    for (int i = 0; i < 131; i++)                                                    
-      t->fdt[i] = NULL;  
+    fdtable_init (&t->fdt);
     sema_init(&(t->sema), 0);
     sema_init(&(t->sema2), 0);
     sema_init(&(t->sema3), 0);
     list_init(&(t->child));
-    list_push_back(&(running_thread()->child), &(t->child_elem));
+    t->leader = t;
+    list_init (&t->uthreads);
+    sema_init (&t->uthreads_gone, 0);
   #endif
 }
 
@@ -637,10 +1186,133 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list))
+  struct thread *next;
+
+  if (ready_cnt == 0)
     return idle_thread;
+
+  next = ready_queue_pop ();
+  if (thread_mlfqs)
+    calc_recent_cpu (next);
+  return next;
+}
+
+/* Returns the highest priority that has a nonempty run queue.
+   The run queue must not be empty. */
+static int
+ready_queue_max_priority (void)
+{
+  uint32_t high = ready_mask >> 32;
+  uint32_t low = ready_mask;
+
+  ASSERT (ready_mask != 0);
+  if (high != 0)
+    return 63 - __builtin_clz (high);
   else
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+    return 31 - __builtin_clz (low);
+}
+
+/* Returns true if a ready thread should preempt running thread
+   T.  A ready real-time thread preempts any thread outside the
+   class and any real-time thread with a later deadline.
+   Otherwise, the stride scheduler never preempts before the end
+   of a time slice, and the priority scheduler preempts for a
+   higher priority.  Interrupts must be off. */
+static bool
+ready_queue_outranks (const struct thread *t)
+{
+  if (!heap_empty (&rt_heap))
+    return (!thread_is_rt (t)
+            || heap_entry (heap_top (&rt_heap), struct thread,
+                           rt_elem)->rt_abs_deadline < t->rt_abs_deadline);
+  if (thread_is_rt (t) || thread_stride)
+    return false;
+  return ready_mask != 0 && ready_queue_max_priority () > t->priority;
+}
+
+/* Appends T to the tail of the run queue for its priority.
+   Interrupts must be off. */
+static void
+ready_queue_push (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+  if (thread_is_rt (t))
+    {
+      heap_push (&rt_heap, &t->rt_elem);
+      ready_cnt++;
+      return;
+    }
+  if (thread_stride)
+    {
+      heap_push (&stride_heap, &t->stride_elem);
+      ready_cnt++;
+      return;
+    }
+  list_push_back (&ready_queues[t->priority], &t->elem);
+  ready_mask |= (uint64_t) 1 << t->priority;
+  ready_cnt++;
+}
+
+/* Removes T, which must be in the run queue for its current
+   priority.  Interrupts must be off. */
+static void
+ready_queue_remove (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status == THREAD_READY);
+
+  if (thread_is_rt (t))
+    {
+      heap_remove (&rt_heap, &t->rt_elem);
+      ready_cnt--;
+      return;
+    }
+  if (thread_stride)
+    {
+      heap_remove (&stride_heap, &t->stride_elem);
+      ready_cnt--;
+      return;
+    }
+  list_remove (&t->elem);
+  if (list_empty (&ready_queues[t->priority]))
+    ready_mask &= ~((uint64_t) 1 << t->priority);
+  ready_cnt--;
+}
+
+/* Removes and returns the ready real-time thread with the
+   earliest deadline, if any, or else the thread at the head of
+   the highest-priority nonempty run queue.  The run queue must
+   not be empty.  Interrupts must be off. */
+static struct thread *
+ready_queue_pop (void)
+{
+  int priority;
+  struct list *queue;
+  struct thread *t;
+
+  if (!heap_empty (&rt_heap))
+    {
+      t = heap_entry (heap_pop (&rt_heap), struct thread, rt_elem);
+      ready_cnt--;
+      return t;
+    }
+  if (thread_stride)
+    {
+      t = heap_entry (heap_pop (&stride_heap), struct thread, stride_elem);
+      stride_pass = t->pass;
+      ready_cnt--;
+      return t;
+    }
+
+  priority = ready_queue_max_priority ();
+  queue = &ready_queues[priority];
+  t = list_entry (list_pop_front (queue), struct thread, elem);
+  if (list_empty (queue))
+    ready_mask &= ~((uint64_t) 1 << priority);
+  ready_cnt--;
+  return t;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -672,6 +1344,27 @@ thread_schedule_tail (struct thread *prev)
   /* Start new time slice. */
   thread_ticks = 0;
 
+  /* If we just left the idle thread, make sure the timer is
+     ticking again and timer_ticks() is up to date. */
+  if (prev == idle_thread)
+    timer_idle_exit ();
+
+  /* Charge the time we spent in the run queue. */
+  if (cur != idle_thread)
+    {
+      int64_t waited = timer_ticks () - cur->ready_since;
+
+      cur->stat.wait_ticks += waited;
+      if (cur->woken)
+        {
+          cur->stat.wakeup_cnt++;
+          cur->stat.wakeup_ticks += waited;
+          if (waited > cur->stat.wakeup_max)
+            cur->stat.wakeup_max = waited;
+          cur->woken = false;
+        }
+    }
+
 #ifdef USERPROG
   /* Activate the new address space. */
   process_activate ();
@@ -707,11 +1400,65 @@ schedule (void)
   ASSERT (cur->status != THREAD_RUNNING);
   ASSERT (is_thread (next));
 
+  account_switch (cur);
   if (cur != next)
     prev = switch_threads (cur, next);
   thread_schedule_tail (prev);
 }
 
+/* Updates the scheduler statistics of CUR, which is about to
+   give up the CPU.  Interrupts must be off. */
+static void
+account_switch (struct thread *cur)
+{
+  if (cur->status == THREAD_READY)
+    {
+      cur->ready_since = timer_ticks ();
+      cur->woken = false;
+    }
+  if (cur->status == THREAD_READY && cur->preempted)
+    cur->stat.involuntary_cnt++;
+  else
+    cur->stat.voluntary_cnt++;
+  cur->preempted = false;
+
+  if ((int64_t) thread_ticks - TIME_SLICE > cur->stat.overrun_max)
+    cur->stat.overrun_max = (int64_t) thread_ticks - TIME_SLICE;
+}
+
+/* Orders ready real-time threads by absolute deadline. */
+static bool
+deadline_less (const struct heap_elem *a_, const struct heap_elem *b_,
+               void *aux UNUSED)
+{
+  const struct thread *a = heap_entry (a_, struct thread, rt_elem);
+  const struct thread *b = heap_entry (b_, struct thread, rt_elem);
+
+  return a->rt_abs_deadline < b->rt_abs_deadline;
+}
+
+/* Orders ready threads by pass, for the stride scheduler. */
+static bool
+pass_less (const struct heap_elem *a_, const struct heap_elem *b_,
+           void *aux UNUSED)
+{
+  const struct thread *a = heap_entry (a_, struct thread, stride_elem);
+  const struct thread *b = heap_entry (b_, struct thread, stride_elem);
+
+  return a->pass < b->pass;
+}
+
+/* Orders sleeping threads by wakeup tick. */
+static bool
+waketime_less (const struct heap_elem *a_, const struct heap_elem *b_,
+               void *aux UNUSED)
+{
+  const struct thread *a = heap_entry (a_, struct thread, sleep_elem);
+  const struct thread *b = heap_entry (b_, struct thread, sleep_elem);
+
+  return a->waketime < b->waketime;
+}
+
 /* Returns a tid to use for a new thread. */
 static tid_t
 allocate_tid (void) 
@@ -3,10 +3,13 @@
 
 #include <debug.h>
 #include <hash.h>
+#include <heap.h>
 #include <list.h>
+#include <schedstat.h>
 #include <stdint.h>
 #include "threads/synch.h"
 #include "filesys/file.h"
+#include "userprog/fdtable.h"
 #include "threads/malloc.h"
 
 /* States in a thread's life cycle. */
@@ -28,6 +31,10 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Stride scheduler tickets. */
+#define THREAD_DEFAULT_TICKETS 100      /* Default tickets. */
+#define THREAD_MAX_TICKETS 1000         /* Most tickets a thread may hold. */
+
 /* A kernel thread or user process.
 
    Each thread structure is stored in its own 4 kB page.  The
@@ -91,15 +98,42 @@ struct thread
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    int priority;                       /* Priority. */
+    int priority;                       /* Effective priority. */
+    int base_priority;                  /* Priority before donations. */
     struct list_elem allelem;           /* List element for all threads list. */
     
-    int waketime;
+    int64_t waketime;                   /* Tick to wake up at, if sleeping. */
+    struct heap_elem sleep_elem;        /* Heap element for sleep queue. */
     int nice;
     int recent_cpu;
+    unsigned mlfqs_epoch;               /* # of recent_cpu decays applied. */
+    int tickets;                        /* Stride scheduler tickets. */
+    int stride;                         /* Pass increment per tick. */
+    int64_t pass;                       /* Virtual time used so far. */
+    struct heap_elem stride_elem;       /* Heap element for stride run queue. */
+
+    /* Real-time class, see thread_set_deadline(). */
+    int64_t rt_runtime;                 /* Budget per period, or 0. */
+    int64_t rt_deadline;                /* Deadline from period start. */
+    int64_t rt_period;                  /* Period length. */
+    int64_t rt_bw;                      /* Density, for admission control. */
+    int64_t rt_budget;                  /* Budget left in this period. */
+    int64_t rt_abs_deadline;            /* Deadline of the current job. */
+    int64_t rt_next_period;             /* Start of the next period. */
+    bool rt_throttled;                  /* Out of budget until next period? */
+    struct heap_elem rt_elem;           /* Heap element for real-time queue. */
+
+    /* Scheduler statistics. */
+    struct schedstat stat;              /* Counters for schedstat. */
+    int64_t ready_since;                /* Tick at which it became ready. */
+    bool woken;                         /* Became ready by thread_unblock()? */
+    bool preempted;                     /* Asked to give up the CPU? */
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
+    struct lock *wait_on_lock;          /* Lock being waited for, if any. */
+    struct list donations;              /* Threads donating priority to us. */
+    struct list_elem donation_elem;     /* List element for donations list. */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
@@ -111,13 +145,30 @@ struct thread
     struct list_elem child_elem;
     int exit_status;
     int failed;
-    struct file* fdt[131];
+    struct fdtable fdt;                 /* Leader: file descriptors. */
+    void *syscall_esp;                  /* User %esp at system call entry. */
+
+    /* User threads.  A process's initial thread is its leader and
+       owns the page directory's contents, the supplemental page
+       table and the file descriptor table; the process's other
+       threads share them through LEADER.  See process.c. */
+    struct thread *leader;              /* Initial thread of process. */
+    struct uthread *uthread;            /* Record, if not the leader. */
+    void *ustack_top;                   /* Top of user stack region. */
+    size_t ustack_size;                 /* Size of user stack region. */
+    struct list uthreads;               /* Leader: other threads' records. */
+    int uthread_cnt;                    /* Leader: # of other threads alive. */
+    uint32_t ustack_slots;              /* Leader: stack slots in use. */
+    bool exiting;                       /* Leader: process is exiting? */
+    bool reaping;                       /* Leader: waiting for threads? */
+    struct semaphore uthreads_gone;     /* Leader: upped when all gone. */
 #endif
 
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
     
     struct hash vm;
+    struct lock vm_lock;                /* Leader: protects vm. */
   };
 
 /* If false (default), use round-robin scheduler.
@@ -125,6 +176,16 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the stride scheduler.
+   Controlled by kernel command-line option "-stride". */
+extern bool thread_stride;
+
+#ifndef USERPROG
+/* If true, age the priorities of waiting threads.
+   Controlled by kernel command-line option "-aging". */
+extern bool thread_prior_aging;
+#endif
+
 void thread_init (void);
 void thread_start (void);
 
@@ -146,10 +207,15 @@ const char *thread_name (void);
 void thread_exit (void) NO_RETURN;
 void thread_yield (void);
 
-bool thread_check_priority (struct list_elem *, struct list_elem *, void *);
+void thread_preempt (void);
+bool thread_priority_less (const struct list_elem *, const struct list_elem *,
+                           void *);
+void thread_donate_priority (struct lock *);
+void thread_remove_donations (struct lock *);
 
 void thread_sleep (int64_t);
 void thread_wake (int64_t);
+int64_t thread_next_wakeup (void);
 
 /* Performs some operation on thread t, given auxiliary data AUX. */
 typedef void thread_action_func (struct thread *t, void *aux);
@@ -163,12 +229,24 @@ void thread_set_nice (int);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
 
+bool thread_get_schedstat (tid_t, struct schedstat *);
+
+int thread_get_tickets (void);
+bool thread_set_tickets (int);
+
+bool thread_set_deadline (int64_t runtime, int64_t deadline, int64_t period);
+
+/* Returns true if T is in the real-time scheduling class. */
+static inline bool
+thread_is_rt (const struct thread *t)
+{
+  return t->rt_runtime != 0;
+}
+
 void calc_priority(struct thread *);
 void calc_recent_cpu(struct thread *);
 void calc_load_avg(void);
 
-void update_priority(void);
-void increase_recent_cpu(void);
-void update_recent_cpu(void);
+void thread_mlfqs_tick (int64_t ticks);
 
 #endif /* threads/thread.h */
@@ -4,6 +4,7 @@
 #include <debug.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "threads/loader.h"
 
@@ -59,6 +60,19 @@ is_user_vaddr (const void *vaddr)
   return vaddr < PHYS_BASE;
 }
 
+/* Returns true if the SIZE bytes starting at VADDR all lie in
+   user virtual memory.  A range that wraps around the end of the
+   address space is not. */
+static inline bool
+is_user_range (const void *vaddr, size_t size)
+{
+  uintptr_t start = (uintptr_t) vaddr;
+
+  return size == 0
+         || (start + size >= start
+             && start + size <= (uintptr_t) PHYS_BASE);
+}
+
 /* Returns true if VADDR is a kernel virtual address. */
 static inline bool
 is_kernel_vaddr (const void *vaddr) 
@@ -0,0 +1,99 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Nice value for worker threads under the MLFQS, which keeps
+   them at the top priority they were created with. */
+#define WORKER_NICE -20
+
+static thread_func worker;
+
+/* Initializes W to call FUNC with auxiliary data AUX when it
+   runs. */
+void
+work_init (struct work *w, work_func *func, void *aux)
+{
+  ASSERT (w != NULL);
+  ASSERT (func != NULL);
+
+  w->func = func;
+  w->aux = aux;
+  w->pending = false;
+}
+
+/* Initializes WQ as an empty workqueue whose worker thread will
+   be called NAME.  Work may be queued on WQ right away, but none
+   of it runs until workqueue_start() is called. */
+void
+workqueue_init (struct workqueue *wq, const char *name)
+{
+  ASSERT (wq != NULL);
+  ASSERT (name != NULL);
+
+  wq->name = name;
+  list_init (&wq->works);
+  sema_init (&wq->work_cnt, 0);
+}
+
+/* Creates WQ's worker thread with the given PRIORITY. */
+void
+workqueue_start (struct workqueue *wq, int priority)
+{
+  if (thread_create (wq->name, priority, worker, wq) == TID_ERROR)
+    PANIC ("%s: cannot create worker thread", wq->name);
+}
+
+/* Queues W on WQ, unless it is already pending.  Returns true if
+   W was queued, false if it was already pending.
+
+   This function does not sleep, so it may be called within an
+   interrupt handler. */
+bool
+workqueue_queue (struct workqueue *wq, struct work *w)
+{
+  enum intr_level old_level;
+  bool queued = false;
+
+  ASSERT (wq != NULL);
+  ASSERT (w != NULL);
+
+  old_level = intr_disable ();
+  if (!w->pending)
+    {
+      w->pending = true;
+      list_push_back (&wq->works, &w->elem);
+      queued = true;
+    }
+  intr_set_level (old_level);
+
+  if (queued)
+    sema_up (&wq->work_cnt);
+  return queued;
+}
+
+/* Worker thread for workqueue WQ_.  Runs works one at a time, in
+   the order they were queued. */
+static void
+worker (void *wq_)
+{
+  struct workqueue *wq = wq_;
+
+  if (thread_mlfqs)
+    thread_set_nice (WORKER_NICE);
+
+  for (;;)
+    {
+      enum intr_level old_level;
+      struct work *w;
+
+      sema_down (&wq->work_cnt);
+
+      old_level = intr_disable ();
+      w = list_entry (list_pop_front (&wq->works), struct work, elem);
+      w->pending = false;
+      intr_set_level (old_level);
+
+      w->func (w->aux);
+    }
+}
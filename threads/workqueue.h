@@ -0,0 +1,45 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/synch.h"
+
+/* Deferred work.
+
+   A work item is a function to call later, in the context of a
+   workqueue's worker thread instead of the caller's.  Queueing
+   work never sleeps, so interrupt handlers can use it to push
+   their processing out of the interrupt, where it runs with
+   interrupts enabled and is scheduled like any other thread.
+
+   A work item that is already queued is not queued again, so
+   queueing the same item many times before it runs makes it run
+   once. */
+
+typedef void work_func (void *aux);
+
+/* A work item. */
+struct work
+  {
+    struct list_elem elem;      /* List element for workqueue. */
+    work_func *func;            /* Function to call. */
+    void *aux;                  /* Auxiliary data for FUNC. */
+    bool pending;               /* Queued but not yet started? */
+  };
+
+/* A queue of work with a dedicated worker thread. */
+struct workqueue
+  {
+    const char *name;           /* Name of worker thread. */
+    struct list works;          /* Pending works, in FIFO order. */
+    struct semaphore work_cnt;  /* Counts pending works. */
+  };
+
+void work_init (struct work *, work_func *, void *aux);
+
+void workqueue_init (struct workqueue *, const char *name);
+void workqueue_start (struct workqueue *, int priority);
+bool workqueue_queue (struct workqueue *, struct work *);
+
+#endif /* threads/workqueue.h */
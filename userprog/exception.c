@@ -8,6 +8,7 @@
 #include "userprog/syscall.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
+#include "userprog/uaccess.h"
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -151,19 +152,33 @@ page_fault (struct intr_frame *f)
   not_present = (f->error_code & PF_P) == 0;
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
+  if (user)
+    process_check_exit ();
   //printf("[(%lld)%p, %p]\n", page_fault_cnt, fault_addr, f->esp);
-   if (not_present){
-      struct vm_entry *vme = find_vme(fault_addr);
-      if (!vme){
-         if (!verify_stack(f->esp, fault_addr)){
-            exit(-1);}
-         expand_stack(fault_addr);
-      }
-      else if (!handle_mm_fault(vme))
-         exit(-1);
+   if (not_present && is_user_vaddr(fault_addr)){
+      /* A kernel access to user memory happens during a system
+         call, so judge stack growth by the user's stack pointer
+         at the time of the call. */
+      void *esp = user ? f->esp : thread_current()->syscall_esp;
+      struct vm_entry *vme;
+      bool handled;
+
+      vm_lock_acquire();
+      vme = find_vme(fault_addr);
+      if (!vme)
+         handled = verify_stack(esp, fault_addr) && expand_stack(fault_addr);
+      else
+         handled = handle_mm_fault(vme);
+      vm_lock_release();
+      if (handled)
+         return;
    }
-   else
-      exit(-1);
+
+   /* A bad user pointer passed to copy_from_user() and friends
+      makes them return an error instead of killing the process. */
+   if (!user && uaccess_fixup(f))
+      return;
+   exit(-1);
 
 //    //TODO
 //    if(not_present || is_kernel_vaddr(fault_addr))
@@ -0,0 +1,252 @@
+#include "userprog/fdtable.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+
+/* Bits in a bitmap word. */
+#define WORD_BITS 32
+
+/* Number of descriptors in a newly allocated table.  Must be a
+   multiple of WORD_BITS. */
+#define FDTABLE_MIN 32
+
+/* Number of descriptors reserved for the console. */
+#define FD_RESERVED 3
+
+static int find_free (const struct fdtable *);
+static bool grow (struct fdtable *, int min_size);
+static void mark_used (struct fdtable *, int fd);
+static void mark_free (struct fdtable *, int fd);
+
+/* Returns the number of words needed for a bitmap of N bits. */
+static inline int
+bitmap_words (int n)
+{
+  return (n + WORD_BITS - 1) / WORD_BITS;
+}
+
+/* Initializes FDT as an empty table.  Does not allocate memory,
+   so that it may be called from thread creation before the heap
+   is ready; the table is allocated when first used. */
+void
+fdtable_init (struct fdtable *fdt)
+{
+  lock_init (&fdt->lock);
+  fdt->files = NULL;
+  fdt->used = NULL;
+  fdt->full = NULL;
+  fdt->size = 0;
+}
+
+/* Closes every file open in FDT and frees its memory, leaving
+   it empty.  No other thread may be using FDT. */
+void
+fdtable_destroy (struct fdtable *fdt)
+{
+  int fd;
+
+  for (fd = FD_RESERVED; fd < fdt->size; fd++)
+    if (fdt->files[fd] != NULL)
+      file_close (fdt->files[fd]);
+  free (fdt->files);
+  free (fdt->used);
+  free (fdt->full);
+  fdt->files = NULL;
+  fdt->used = NULL;
+  fdt->full = NULL;
+  fdt->size = 0;
+}
+
+/* Installs FILE in FDT at the lowest free descriptor, growing
+   the table if needed, and returns the descriptor.  Returns -1
+   if memory cannot be allocated. */
+int
+fdtable_install (struct fdtable *fdt, struct file *file)
+{
+  int fd;
+
+  ASSERT (file != NULL);
+
+  lock_acquire (&fdt->lock);
+  fd = find_free (fdt);
+  if (fd < 0 && grow (fdt, fdt->size + 1))
+    fd = find_free (fdt);
+  if (fd >= 0)
+    {
+      fdt->files[fd] = file;
+      mark_used (fdt, fd);
+    }
+  lock_release (&fdt->lock);
+  return fd;
+}
+
+/* Installs FILE in FDT at descriptor FD, which must be free,
+   growing the table if needed.  Returns false if memory cannot
+   be allocated. */
+bool
+fdtable_install_at (struct fdtable *fdt, int fd, struct file *file)
+{
+  bool success = true;
+
+  ASSERT (fd >= FD_RESERVED);
+  ASSERT (file != NULL);
+
+  lock_acquire (&fdt->lock);
+  if (fd >= fdt->size)
+    success = grow (fdt, fd + 1);
+  if (success)
+    {
+      ASSERT (fdt->files[fd] == NULL);
+      fdt->files[fd] = file;
+      mark_used (fdt, fd);
+    }
+  lock_release (&fdt->lock);
+  return success;
+}
+
+/* Returns the file open as FD in FDT, or a null pointer if FD is
+   not open or is a console descriptor.  The file is returned with
+   a new reference, which the caller must drop with file_close(),
+   so that it stays open even if FD is closed meanwhile. */
+struct file *
+fdtable_get (struct fdtable *fdt, int fd)
+{
+  struct file *file = NULL;
+
+  lock_acquire (&fdt->lock);
+  if (fd >= FD_RESERVED && fd < fdt->size && fdt->files[fd] != NULL)
+    file = file_ref (fdt->files[fd]);
+  lock_release (&fdt->lock);
+  return file;
+}
+
+/* Removes FD from FDT and returns the file that was open as FD,
+   or a null pointer if FD was not open.  The caller takes over
+   FDT's reference to the file and must drop it with
+   file_close(). */
+struct file *
+fdtable_remove (struct fdtable *fdt, int fd)
+{
+  struct file *file = NULL;
+
+  lock_acquire (&fdt->lock);
+  if (fd >= FD_RESERVED && fd < fdt->size && fdt->files[fd] != NULL)
+    {
+      file = fdt->files[fd];
+      fdt->files[fd] = NULL;
+      mark_free (fdt, fd);
+    }
+  lock_release (&fdt->lock);
+  return file;
+}
+
+/* Returns one more than the highest descriptor that can
+   currently be open in FDT. */
+int
+fdtable_size (struct fdtable *fdt)
+{
+  int size;
+
+  lock_acquire (&fdt->lock);
+  size = fdt->size;
+  lock_release (&fdt->lock);
+  return size;
+}
+
+/* Returns the lowest free descriptor in FDT, or -1 if FDT is
+   full. */
+static int
+find_free (const struct fdtable *fdt)
+{
+  int words = bitmap_words (fdt->size);
+  int i;
+
+  for (i = 0; i < bitmap_words (words); i++)
+    if (fdt->full[i] != UINT32_MAX)
+      {
+        int w = i * WORD_BITS + __builtin_ctz (~fdt->full[i]);
+
+        /* Bits of FULL past the end of USED are clear, so a clear
+           bit there means every real word is full. */
+        if (w >= words)
+          return -1;
+        return w * WORD_BITS + __builtin_ctz (~fdt->used[w]);
+      }
+  return -1;
+}
+
+/* Grows FDT to hold at least MIN_SIZE descriptors, at least
+   doubling its size.  Returns false if memory cannot be
+   allocated, in which case FDT is unchanged. */
+static bool
+grow (struct fdtable *fdt, int min_size)
+{
+  int old_size = fdt->size;
+  int new_size = old_size > 0 ? old_size * 2 : FDTABLE_MIN;
+  int old_words = bitmap_words (old_size);
+  int new_words, old_full, new_full;
+  struct file **files;
+  uint32_t *used, *full;
+  int fd;
+
+  while (new_size < min_size)
+    new_size *= 2;
+  new_words = bitmap_words (new_size);
+  old_full = bitmap_words (old_words);
+  new_full = bitmap_words (new_words);
+
+  files = malloc (new_size * sizeof *files);
+  used = malloc (new_words * sizeof *used);
+  full = malloc (new_full * sizeof *full);
+  if (files == NULL || used == NULL || full == NULL)
+    {
+      free (files);
+      free (used);
+      free (full);
+      return false;
+    }
+
+  memset (files, 0, new_size * sizeof *files);
+  memset (used, 0, new_words * sizeof *used);
+  memset (full, 0, new_full * sizeof *full);
+  if (old_size > 0)
+    {
+      memcpy (files, fdt->files, old_size * sizeof *files);
+      memcpy (used, fdt->used, old_words * sizeof *used);
+      memcpy (full, fdt->full, old_full * sizeof *full);
+    }
+  free (fdt->files);
+  free (fdt->used);
+  free (fdt->full);
+  fdt->files = files;
+  fdt->used = used;
+  fdt->full = full;
+  fdt->size = new_size;
+
+  if (old_size == 0)
+    for (fd = 0; fd < FD_RESERVED; fd++)
+      mark_used (fdt, fd);
+  return true;
+}
+
+/* Marks FD in use in FDT's bitmaps. */
+static void
+mark_used (struct fdtable *fdt, int fd)
+{
+  int w = fd / WORD_BITS;
+
+  fdt->used[w] |= 1u << (fd % WORD_BITS);
+  if (fdt->used[w] == UINT32_MAX)
+    fdt->full[w / WORD_BITS] |= 1u << (w % WORD_BITS);
+}
+
+/* Marks FD free in FDT's bitmaps. */
+static void
+mark_free (struct fdtable *fdt, int fd)
+{
+  int w = fd / WORD_BITS;
+
+  fdt->used[w] &= ~(1u << (fd % WORD_BITS));
+  fdt->full[w / WORD_BITS] &= ~(1u << (w % WORD_BITS));
+}
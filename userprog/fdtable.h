@@ -0,0 +1,42 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+
+/* A process's file descriptor table.
+
+   The table maps file descriptors to open files.  It lives in
+   memory from malloc(), not in the process's thread page, and
+   doubles in size whenever it fills up, so there is no fixed
+   limit on the number of open files.
+
+   Free descriptors are tracked in a two-level bitmap: a bit in
+   USED per descriptor, and a bit in FULL per word of USED that
+   has no free descriptors left.  Finding the lowest free
+   descriptor looks at one word of FULL for each 1,024
+   descriptors in the table and one word of USED, so opening and
+   closing files costs the same however many are open.
+
+   Descriptors 0, 1 and 2 are reserved for the console and are
+   never handed out. */
+struct fdtable
+  {
+    struct lock lock;           /* Protects all the members below. */
+    struct file **files;        /* Open file for each descriptor. */
+    uint32_t *used;             /* Bit set if descriptor in use. */
+    uint32_t *full;             /* Bit set if word of USED is full. */
+    int size;                   /* Number of descriptors in table. */
+  };
+
+void fdtable_init (struct fdtable *);
+void fdtable_destroy (struct fdtable *);
+
+int fdtable_install (struct fdtable *, struct file *);
+bool fdtable_install_at (struct fdtable *, int fd, struct file *);
+struct file *fdtable_get (struct fdtable *, int fd);
+struct file *fdtable_remove (struct fdtable *, int fd);
+int fdtable_size (struct fdtable *);
+
+#endif /* userprog/fdtable.h */
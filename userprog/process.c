@@ -23,8 +23,41 @@
 #include "vm/frame.h"
 #include "vm/swap.h"
 
+/* Stack size limit of a process's initial thread, whose stack
+   ends at PHYS_BASE. */
+#define STACK_MAX (8 * 1024 * 1024)
+
+/* A process may have up to UTHREAD_MAX threads besides its
+   initial thread.  Their stacks, each of up to UTHREAD_STACK_MAX
+   bytes, occupy consecutive slots below the initial thread's. */
+#define UTHREAD_MAX 32
+#define UTHREAD_STACK_MAX (1024 * 1024)
+
+/* A user thread other than a process's initial thread.  The
+   record is kept on its leader's `uthreads' list until another
+   thread joins it or the process exits, so that it outlives the
+   thread itself. */
+struct uthread
+  {
+    struct list_elem elem;      /* Element in leader's `uthreads'. */
+    tid_t tid;                  /* Thread's tid. */
+    int slot;                   /* User stack slot. */
+    bool joined;                /* Has a thread started joining it? */
+    struct semaphore done;      /* Upped when the thread exits. */
+
+    /* Used while starting up. */
+    struct thread *leader;      /* Leader of process to join. */
+    void (*entry) (void);       /* User code to start at. */
+    void *func, *aux;           /* Arguments passed to ENTRY. */
+    struct semaphore started;   /* Upped once the thread has a stack. */
+    bool success;               /* Did it get one? */
+  };
+
 static thread_func start_process NO_RETURN;
+static thread_func start_uthread NO_RETURN;
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
+static void uthread_exit (struct thread *);
+static void wait_uthreads (struct thread *leader);
 
 /* Starts a new thread running a user program loaded from
  FILENAME.  The new thread may be scheduled (and may even exit)
@@ -80,8 +113,13 @@ start_process (void *file_name_)
 char *file_name = file_name_;
 struct intr_frame if_;
 bool success;
+struct thread *cur = thread_current ();
+enum intr_level old_level;
 
 vm_init(&thread_current()->vm);
+lock_init(&cur->vm_lock);
+cur->ustack_top = PHYS_BASE;
+cur->ustack_size = STACK_MAX;
 
 /* Initialize interrupt frame and load executable. */
 memset (&if_, 0, sizeof if_);
@@ -92,6 +130,29 @@ success = load (file_name, &if_.eip, &if_.esp);
 
 /* If load failed, quit. */
 free_page (file_name);
+/* Inherit the parent's pipes, at the same descriptors.  The
+   parent is blocked on sema3 until we are done. */
+if (success)
+  {
+    struct fdtable *pfdt = &cur->parent->leader->fdt;
+    int size = fdtable_size (pfdt);
+    int i;
+
+    for (i = 0; i < size; i++)
+      {
+        struct file *f = fdtable_get (pfdt, i);
+        if (f != NULL && file_is_pipe (f))
+          {
+            struct file *copy = file_reopen (f);
+            if (copy != NULL && !fdtable_install_at (&cur->fdt, i, copy))
+              file_close (copy);
+          }
+        file_close (f);
+      }
+  }
+old_level = intr_disable ();
+list_push_back (&cur->parent->child, &cur->child_elem);
+intr_set_level (old_level);
 sema_up(&thread_current()->parent->sema3);
 if (!success) {
   thread_current()->failed=1;
@@ -138,17 +199,259 @@ process_wait (tid_t child_tid)
 	return -1;
 }
 
+/* Starts a new thread in the current process, sharing its
+   address space and open files.  The thread begins running user
+   code at ENTRY, with a stack of its own holding FUNC and AUX as
+   ENTRY's arguments.  Returns the new thread's tid, or TID_ERROR
+   if the thread cannot be created. */
+tid_t
+process_thread_create (void (*entry) (void), void *func, void *aux)
+{
+  struct thread *leader = thread_current ()->leader;
+  struct uthread *ut;
+  enum intr_level old_level;
+  tid_t tid;
+
+  ut = malloc (sizeof *ut);
+  if (ut == NULL)
+    return TID_ERROR;
+  ut->joined = false;
+  sema_init (&ut->done, 0);
+  ut->leader = leader;
+  ut->entry = entry;
+  ut->func = func;
+  ut->aux = aux;
+  sema_init (&ut->started, 0);
+
+  /* Claim a stack slot. */
+  old_level = intr_disable ();
+  if (leader->exiting || leader->uthread_cnt >= UTHREAD_MAX)
+    {
+      intr_set_level (old_level);
+      free (ut);
+      return TID_ERROR;
+    }
+  ut->slot = __builtin_ctz (~leader->ustack_slots);
+  leader->ustack_slots |= 1u << ut->slot;
+  leader->uthread_cnt++;
+  list_push_back (&leader->uthreads, &ut->elem);
+  intr_set_level (old_level);
+
+  tid = thread_create (leader->name, thread_get_priority (),
+                       start_uthread, ut);
+  if (tid == TID_ERROR)
+    {
+      old_level = intr_disable ();
+      leader->ustack_slots &= ~(1u << ut->slot);
+      leader->uthread_cnt--;
+      list_remove (&ut->elem);
+      intr_set_level (old_level);
+      free (ut);
+      return TID_ERROR;
+    }
+
+  sema_down (&ut->started);
+  if (!ut->success)
+    {
+      process_thread_join (tid);
+      return TID_ERROR;
+    }
+  return tid;
+}
+
+/* A thread function that sets up a user thread created by
+   process_thread_create() and starts it running. */
+static void
+start_uthread (void *ut_)
+{
+  struct uthread *ut = ut_;
+  struct thread *cur = thread_current ();
+  struct thread *leader = ut->leader;
+  struct intr_frame if_;
+  uint32_t *esp;
+
+  cur->leader = leader;
+  cur->uthread = ut;
+  cur->pagedir = leader->pagedir;
+  cur->ustack_top = ((uint8_t *) PHYS_BASE - STACK_MAX
+                     - ut->slot * UTHREAD_STACK_MAX);
+  cur->ustack_size = UTHREAD_STACK_MAX;
+  ut->tid = cur->tid;
+  process_activate ();
+
+  memset (&if_, 0, sizeof if_);
+  if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+  if_.cs = SEL_UCSEG;
+  if_.eflags = FLAG_IF | FLAG_MBS;
+  if_.eip = ut->entry;
+
+  /* Push FUNC and AUX, and a null return address, on a fresh
+     stack page. */
+  vm_lock_acquire ();
+  ut->success = expand_stack ((uint8_t *) cur->ustack_top - PGSIZE);
+  vm_lock_release ();
+  if (ut->success)
+    {
+      esp = (uint32_t *) cur->ustack_top - 3;
+      esp[0] = 0;
+      esp[1] = (uint32_t) ut->func;
+      esp[2] = (uint32_t) ut->aux;
+      if_.esp = esp;
+    }
+  sema_up (&ut->started);
+  if (!ut->success)
+    thread_exit ();
+
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* Waits for thread TID, which must be another thread of the
+   current process that no other thread has joined, to exit.
+   Returns true if successful, false if TID is not such a
+   thread. */
+bool
+process_thread_join (tid_t tid)
+{
+  struct thread *cur = thread_current ();
+  struct thread *leader = cur->leader;
+  struct uthread *ut = NULL;
+  struct list_elem *e;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  for (e = list_begin (&leader->uthreads); e != list_end (&leader->uthreads);
+       e = list_next (e))
+    {
+      struct uthread *u = list_entry (e, struct uthread, elem);
+      if (u->tid == tid && !u->joined && tid != cur->tid)
+        {
+          ut = u;
+          ut->joined = true;
+          break;
+        }
+    }
+  intr_set_level (old_level);
+  if (ut == NULL)
+    return false;
+
+  sema_down (&ut->done);
+  old_level = intr_disable ();
+  list_remove (&ut->elem);
+  intr_set_level (old_level);
+  free (ut);
+  return true;
+}
+
+/* Makes the current thread exit.  The process exits, with status
+   0, when its initial thread exits this way, but only after all
+   of its other threads have. */
+void
+process_thread_exit (void)
+{
+  struct thread *cur = thread_current ();
+
+  if (cur->leader == cur)
+    {
+      wait_uthreads (cur);
+      exit (0);
+    }
+  thread_exit ();
+}
+
+/* Makes the current thread exit if another thread of its
+   process has made the process exit.  Called whenever a thread
+   enters the kernel from user mode, so that every thread of an
+   exiting process soon notices. */
+void
+process_check_exit (void)
+{
+  if (thread_current ()->leader->exiting)
+    thread_exit ();
+}
+
+/* Waits until all of LEADER's other threads have exited.  LEADER
+   must be the current thread. */
+static void
+wait_uthreads (struct thread *leader)
+{
+  enum intr_level old_level;
+
+  ASSERT (leader == thread_current ());
+
+  old_level = intr_disable ();
+  if (leader->uthread_cnt > 0)
+    {
+      leader->reaping = true;
+      sema_down (&leader->uthreads_gone);
+      leader->reaping = false;
+    }
+  intr_set_level (old_level);
+}
+
+/* Frees the resources of user thread CUR, which is not its
+   process's initial thread, and lets a joining thread and the
+   process's leader know that it is gone. */
+static void
+uthread_exit (struct thread *cur)
+{
+  struct thread *leader = cur->leader;
+  struct uthread *ut = cur->uthread;
+  uint8_t *upage;
+  enum intr_level old_level;
+
+  vm_lock_acquire ();
+  for (upage = (uint8_t *) cur->ustack_top - cur->ustack_size;
+       upage < (uint8_t *) cur->ustack_top; upage += PGSIZE)
+    {
+      struct vm_entry *vme = find_vme (upage);
+      if (vme != NULL)
+        delete_vme (&leader->vm, vme);
+    }
+  vm_lock_release ();
+
+  /* The leader destroys the page directory once we are gone. */
+  cur->pagedir = NULL;
+  pagedir_activate (NULL);
+
+  /* UT may be freed as soon as DONE is upped. */
+  old_level = intr_disable ();
+  leader->ustack_slots &= ~(1u << ut->slot);
+  sema_up (&ut->done);
+  if (--leader->uthread_cnt == 0 && leader->reaping)
+    sema_up (&leader->uthreads_gone);
+  intr_set_level (old_level);
+}
+
 /* Free the current process's resources. */
 void
 process_exit (void)
 {
 struct thread *cur = thread_current ();
 uint32_t *pd;
+struct list_elem *e;
+
+if (cur->leader != cur)
+  {
+    uthread_exit (cur);
+    return;
+  }
+
+/* Make the process's other threads exit, and wait for them.
+   Then free the records of those that were not joined. */
+cur->exiting = true;
+wait_uthreads (cur);
+while (!list_empty (&cur->uthreads))
+  {
+    e = list_pop_front (&cur->uthreads);
+    free (list_entry (e, struct uthread, elem));
+  }
+
+fdtable_destroy (&cur->fdt);
 
 vm_destroy(&cur->vm);
 /* Destroy the current process's page directory and switch back
 	 to the kernel-only page directory. */
-spt_destroy(&cur->spage);
 pd = cur->pagedir;
 if (pd != NULL) 
 	{
@@ -494,7 +797,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
       size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
-      struct vm_entry *vme = malloc(sizeof(struct vm_entry));
+      struct vm_entry *vme = calloc(1, sizeof(struct vm_entry));
       if (!vme)
         return false;
 
@@ -504,11 +807,17 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       vme->is_loaded = false;
       vme->file = file;
       vme->offset = ofs;
-      vme->pinned = false;
       vme->read_bytes = page_read_bytes;
       vme->zero_bytes = page_zero_bytes;
       
-      insert_vme(&thread_current()->vm, vme);
+      vm_lock_acquire ();
+      if (!insert_vme(&thread_current()->leader->vm, vme))
+        {
+          vm_lock_release ();
+          free (vme);
+          return false;
+        }
+      vm_lock_release ();
       
       // /* Get a page of memory. */
       // uint8_t *kpage = palloc_get_page (PAL_USER);
@@ -546,22 +855,29 @@ setup_stack (void **esp)
 {
   struct page *kpage;
   bool success = false;
+  struct vm_entry *vme = calloc(1, sizeof(struct vm_entry));
 
-  kpage = alloc_page (PAL_USER | PAL_ZERO);
-  success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage->kaddr, true);
+  if (vme == NULL)
+    return false;
+  vme->type = VM_ANON;
+  vme->vaddr = ((uint8_t *) PHYS_BASE) - PGSIZE;
+  vme->writable = true;
+  vme->is_loaded = true;
+  kpage = alloc_page (PAL_USER | PAL_ZERO, vme);
+  success = install_page (vme->vaddr, kpage->kaddr, true);
   if (success){
-    *esp = PHYS_BASE;
-    struct vm_entry *vme = malloc(sizeof(struct vm_entry));
-    vme->type = VM_ANON;
-    vme->vaddr = ((uint8_t *) PHYS_BASE) - PGSIZE;
-    vme->writable = true;
-    vme->is_loaded = true;
-    vme->pinned = false;
-    kpage->vme = vme;
-    insert_vme(&thread_current()->vm, vme);
+    frame_installed (kpage);
+    vm_lock_acquire ();
+    success = insert_vme(&thread_current()->leader->vm, vme);
+    vm_lock_release ();
   }
+  if (success)
+    *esp = PHYS_BASE;
   else
-    free_page (kpage);
+    {
+      free_page (kpage->kaddr);
+      free (vme);
+    }
   return success;
 }
 
@@ -585,10 +901,20 @@ install_page (void *upage, void *kpage, bool writable)
           && pagedir_set_page (t->pagedir, upage, kpage, writable));
 }
 
+/* Brings VME's page into memory and maps it.  Must be called
+   with the supplemental page table lock held. */
 bool handle_mm_fault(struct vm_entry *vme)
 {
-  struct page *kpage = alloc_page (PAL_USER);
-  kpage->vme = vme;
+  struct page *kpage;
+
+  /* Another thread of the process may have mapped the page
+     between our fault and our taking the lock. */
+  if (vme->is_loaded)
+    return true;
+
+  kpage = alloc_page (PAL_USER, vme);
+  if (kpage == NULL)
+    return vme->is_loaded;
 	switch(vme->type)
 	{
 		case VM_BIN:
@@ -602,6 +928,7 @@ bool handle_mm_fault(struct vm_entry *vme)
 			break;
 		case VM_ANON:
       swap_in(vme->swap_slot, kpage->kaddr);
+      vme->swap_slot = SWAP_SLOT_NONE;
 			break;
 	}
 	if (!install_page (vme->vaddr, kpage->kaddr, vme->writable))
@@ -610,34 +937,42 @@ bool handle_mm_fault(struct vm_entry *vme)
 		return false;
 	}
 	vme->is_loaded=true;
+  frame_installed (kpage);
 	return true;
 }
 
+/* Maps a new zeroed stack page at ADDR.  Must be called with
+   the supplemental page table lock held. */
 bool expand_stack(void *addr)
 {
+  struct vm_entry *vme = calloc(1, sizeof(struct vm_entry));
+  struct hash *vm = &thread_current()->leader->vm;
   struct page *kpage;
-  bool success = false;
-  struct vm_entry *vme = malloc(sizeof(struct vm_entry));
-  kpage = alloc_page (PAL_USER | PAL_ZERO);
-  if (vme){
-    vme->type = VM_ANON;
-    vme->vaddr = pg_round_down(addr);
-    vme->writable = true;
-    vme->is_loaded = true;
-    vme->pinned = false;
-    kpage->vme = vme;
-    insert_vme(&thread_current()->vm, vme);
-
-    success = install_page (vme->vaddr, kpage->kaddr, vme->writable);
-    if (!success){
-      free_page(kpage->kaddr);
-		  free(vme);
-    }
+
+  if (!vme)
+    return false;
+  vme->type = VM_ANON;
+  vme->vaddr = pg_round_down(addr);
+  vme->writable = true;
+  vme->is_loaded = true;
+  if (!insert_vme(vm, vme))
+  {
+    free(vme);
+    return false;
   }
-  return success;
+
+  kpage = alloc_page (PAL_USER | PAL_ZERO, vme);
+  if (!install_page (vme->vaddr, kpage->kaddr, vme->writable))
+  {
+    delete_vme(vm, vme);
+    return false;
+  }
+  frame_installed (kpage);
+  return true;
 }
 
 bool verify_stack(void *esp, void *addr)
 {
-  return (PHYS_BASE - 8*1024*1024 <= addr) && (esp - 32 <= addr) && (addr < PHYS_BASE);
+  struct thread *t = thread_current ();
+  return (t->ustack_top - t->ustack_size <= addr) && (esp - 32 <= addr) && (addr < t->ustack_top);
 }
\ No newline at end of file
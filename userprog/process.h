@@ -10,6 +10,11 @@ void process_exit (void);
 void process_activate (void);
 bool handle_mm_fault(struct vm_entry *);
 
+tid_t process_thread_create (void (*entry) (void), void *func, void *aux);
+bool process_thread_join (tid_t);
+void process_thread_exit (void) NO_RETURN;
+void process_check_exit (void);
+
 bool verify_stack(void *, void *);
 bool expand_stack(void *);
 
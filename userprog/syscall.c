@@ -1,6 +1,7 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include <syscall-nr.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
@@ -11,25 +12,55 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/off_t.h"
+#include "filesys/pipe.h"
 #include "threads/synch.h"
 #include "vm/page.h"
+#include "vm/frame.h"
+#include "userprog/sysenter.h"
+#include "userprog/uaccess.h"
+#include "filesys/directory.h"
+#include "threads/palloc.h"
 
-struct lock syn_lock;
+/* Most bytes of user buffer that a read or write pins at once.
+   Larger transfers are done in chunks, so that one system call
+   cannot pin the whole user pool and leave the page-out daemon
+   nothing to evict. */
+#define PIN_MAX (16 * PGSIZE)
+
+static struct file *lookup_fd (int fd);
+static int transfer (struct file *, void *buffer, unsigned size,
+		     int offset, bool to_read);
+static int transfer_iovec (struct file *, const struct iovec *,
+			   int iovcnt, bool to_read);
+static size_t iovec_pages (const struct iovec *, int iovcnt);
+static char *get_user_string (const void *ustr, char *kstr, size_t size);
+static bool get_user_iovec (const struct iovec *uiov, int iovcnt,
+			    struct iovec *kiov, bool to_write);
+static bool pin_iovec (const struct iovec *, int iovcnt);
+static void unpin_iovec (const struct iovec *, int iovcnt);
 
-static void syscall_handler (struct intr_frame *);
 
 void
 syscall_init (void) 
 {
-	lock_init(&syn_lock);
   	intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
+	sysenter_init();
 }
 
-static void
+/* Handles a system call made through int $0x30 or, via
+   sysenter_entry, through SYSENTER. */
+void
 syscall_handler (struct intr_frame *f) 
 {
-	int *args = (int *)f->esp;
-	check_address((void*) args, f->esp);
+	int *uargs = (int *)f->esp;
+	int args[5];		/* System call number and arguments. */
+	char name[NAME_MAX + 1];
+	char *str;
+
+	process_check_exit();
+	thread_current()->syscall_esp = f->esp;
+	if (copy_from_user(args, uargs, sizeof *args) != 0)
+		exit(-1);
 	//printf("<%d>",args[0]);
 	switch(args[0])
 	{
@@ -37,76 +68,148 @@ syscall_handler (struct intr_frame *f)
 			halt();
 			break;
 		case SYS_EXIT:
-			check_user(args, 1);
+			check_user(args, uargs, 1);
 			exit(args[1]);
 			break;
 		case SYS_EXEC:
-			check_user(args, 1);
-			check_valid_string((void *)args[1], f->esp);
-			f->eax = exec((char *)args[1]);
+			check_user(args, uargs, 1);
+			str = palloc_get_page(0);
+			if (str == NULL)
+			{
+				f->eax = PID_ERROR;
+				break;
+			}
+			f->eax = get_user_string((void *)args[1], str, PGSIZE) ? exec(str) : PID_ERROR;
+			palloc_free_page(str);
 			break;
 		case SYS_WAIT:
-			check_user(args, 1);
+			check_user(args, uargs, 1);
 			f->eax = wait((pid_t)args[1]);
 			break;
 		case SYS_CREATE:
-			check_user(args, 2);
-			check_valid_string((void *)args[1], f->esp);
-			f->eax = create ((char *)args[1], (unsigned)args[2]);
+			check_user(args, uargs, 2);
+			str = get_user_string((void *)args[1], name, sizeof name);
+			f->eax = str ? create (str, (unsigned)args[2]) : false;
       		break;
 		case SYS_REMOVE:
-			check_user(args, 1);
-			check_valid_string((void *)args[1], f->esp);
-			f->eax = remove ((char *)args[1]);
+			check_user(args, uargs, 1);
+			str = get_user_string((void *)args[1], name, sizeof name);
+			f->eax = str ? remove (str) : false;
 			break;
 		case SYS_OPEN:
-			check_user(args, 1);
-			check_valid_string((void *)args[1], f->esp);
-			f->eax = open ((char *)args[1]);
+			check_user(args, uargs, 1);
+			str = get_user_string((void *)args[1], name, sizeof name);
+			f->eax = str ? open (str) : -1;
 			//printf("{open: %d}",f->eax);
 			break;
 		case SYS_FILESIZE:
-			check_user(args, 1);
+			check_user(args, uargs, 1);
 			f->eax = filesize (args[1]);
 			break;
 		case SYS_READ:
-			check_user(args, 3);
-			check_valid_strlen((void *)args[2], (unsigned)args[3], f->esp);
+			check_user(args, uargs, 3);
+			check_valid_buffer((void *)args[2], (unsigned)args[3], f->esp, true);
 			f->eax = read(args[1], (void *)args[2], (unsigned)args[3]);
 			break;
 		case SYS_WRITE:
-			check_user(args, 3);
-			check_valid_strlen((void *)args[2], (unsigned)args[3], f->esp);
+			check_user(args, uargs, 3);
+			check_valid_buffer((void *)args[2], (unsigned)args[3], f->esp, false);
 			f->eax = write(args[1], (void *)args[2], (unsigned)args[3]);
 			break;
 		case SYS_SEEK:
-			check_user(args, 2);
+			check_user(args, uargs, 2);
 			seek (args[1], (unsigned)args[2]);
       		break;
 		case SYS_TELL:
-			check_user(args, 1);
+			check_user(args, uargs, 1);
 			f->eax = tell (args[1]);
 			break;
 		case SYS_CLOSE:
-			check_user(args, 1);
+			check_user(args, uargs, 1);
 			close (args[1]);
 			break;
 		case SYS_FIBO:
-			check_user(args, 1);
+			check_user(args, uargs, 1);
 			f->eax = fibonacci(args[1]);
 			break;
 		case SYS_MAX:
-			check_user(args, 4);
+			check_user(args, uargs, 4);
 			f->eax = max_of_four_int(args[1], args[2], args[3], args[4]);
 			break;
+		case SYS_SCHEDSTAT:
+			check_user(args, uargs, 2);
+			f->eax = schedstat((pid_t)args[1], (struct schedstat *)args[2]);
+			break;
+		case SYS_SET_TICKETS:
+			check_user(args, uargs, 1);
+			f->eax = set_tickets(args[1]);
+			break;
+		case SYS_SET_DEADLINE:
+			check_user(args, uargs, 3);
+			f->eax = set_deadline(args[1], args[2], args[3]);
+			break;
+		case SYS_THREAD_CREATE:
+			check_user(args, uargs, 3);
+			f->eax = sys_thread_create((void (*)(void))args[1], (void (*)(void *))args[2], (void *)args[3]);
+			break;
+		case SYS_THREAD_JOIN:
+			check_user(args, uargs, 1);
+			f->eax = sys_thread_join(args[1]);
+			break;
+		case SYS_THREAD_EXIT:
+			sys_thread_exit();
+			break;
+		case SYS_PIPE:
+			check_user(args, uargs, 1);
+			f->eax = pipe((int *)args[1]);
+			break;
+		case SYS_READV:
+			check_user(args, uargs, 3);
+			f->eax = readv(args[1], (struct iovec *)args[2], args[3]);
+			break;
+		case SYS_WRITEV:
+			check_user(args, uargs, 3);
+			f->eax = writev(args[1], (struct iovec *)args[2], args[3]);
+			break;
+		case SYS_PREAD:
+			check_user(args, uargs, 4);
+			check_valid_buffer((void *)args[2], (unsigned)args[3], f->esp, true);
+			f->eax = pread(args[1], (void *)args[2], (unsigned)args[3], (unsigned)args[4]);
+			break;
+		case SYS_PWRITE:
+			check_user(args, uargs, 4);
+			check_valid_buffer((void *)args[2], (unsigned)args[3], f->esp, false);
+			f->eax = pwrite(args[1], (void *)args[2], (unsigned)args[3], (unsigned)args[4]);
+			break;
+		case SYS_VMSTAT:
+			check_user(args, uargs, 1);
+			f->eax = vmstat((struct vmstat *)args[1]);
+			break;
 	}
+	process_check_exit();
+
+}
 
+/* Copies the NUM arguments of a system call from the user stack
+   UARGS into ARGS[1] onward, killing the process if they cannot
+   be read. */
+void check_user(int *args, const int *uargs, int num)
+{
+	if (copy_from_user(&args[1], &uargs[1], num * sizeof *args) != 0)
+		exit(-1);
 }
 
-void check_user(int *args, int num)
+/* Copies the string at user address USTR into KSTR, which has room
+   for SIZE bytes, and returns KSTR.  Returns a null pointer if the
+   string is too long to fit, or kills the process if USTR cannot be
+   read. */
+static char *get_user_string (const void *ustr, char *kstr, size_t size)
 {
-	for(int i = 1; i < num + 1; i++)
-		check_address((void *)&args[i], (void *)args);
+	int len = strncpy_from_user(kstr, ustr, size);
+
+	if (len < 0)
+		exit(-1);
+	return (size_t) len < size ? kstr : NULL;
 }
 
 struct vm_entry *check_address(void *addr, void *esp)
@@ -115,45 +218,28 @@ struct vm_entry *check_address(void *addr, void *esp)
 	if(addr < 0x8048000 || 0xc0000000 <= addr) {
 		exit(-1);
 	}
+	vm_lock_acquire();
 	struct vm_entry *vme = find_vme(addr);
-	if (!vme){
-		if (!verify_stack(esp, addr))
-            exit(-1);
-         expand_stack(addr);
-		 vme = find_vme(addr);
-	}
+	if (!vme && verify_stack(esp, addr) && expand_stack(addr))
+		vme = find_vme(addr);
+	vm_lock_release();
+	if (!vme)
+		exit(-1);
 	return vme;
 }
 
-void check_valid_buffer (void *buffer, unsigned size, void *esp, bool to_write UNUSED)
-{
-	for(void *addr = pg_round_down(buffer); addr < buffer + size; addr += PGSIZE)
-	{
-		struct vm_entry *vme = check_address(addr, esp);
-		if (!vme || !vme->writable)
-			exit(-1);
-	}
-}
-
-void check_valid_string (void *str, void *esp)
+/* Checks each page of the SIZE-byte user BUFFER, once per page,
+   and kills the process unless they are all mapped (and writable,
+   if TO_WRITE).  read() and write() do I/O straight to and from
+   the user's pages, which pin_vme() then pins. */
+void check_valid_buffer (void *buffer, unsigned size, void *esp, bool to_write)
 {
-	struct vm_entry *vme = check_address(str, esp);
-	if(!vme)
+	if (!is_user_range(buffer, size))
 		exit(-1);
-	int size = strlen(str);
-	for(void *addr = pg_round_down(str); addr < str + size; addr += PGSIZE)
+	for(void *addr = buffer; addr < buffer + size; addr = pg_round_down(addr) + PGSIZE)
 	{
-		vme = check_address(addr, esp);
-		if (!vme)
-			exit(-1);
-	}
-}
-
-void check_valid_strlen (void *str, unsigned size, void *esp)
-{
-	for (int i = 0; i < size; i++){
-		struct vm_entry *vme = check_address(str+i, esp);
-		if(!vme)
+		struct vm_entry *vme = check_address(addr, esp);
+		if (!vme || (to_write && !vme->writable))
 			exit(-1);
 	}
 }
@@ -163,16 +249,22 @@ void halt(void)
 	shutdown_power_off();
 }
 
+/* Exits the whole process, not just the calling thread.  Only
+   the first thread to get here reports the status; the process's
+   other threads exit as they next enter the kernel, and its files
+   are closed in process_exit() once the last of them is gone. */
 void exit(int status)
 {
-	printf("%s: exit(%d)\n",thread_name(),status);
-	thread_current()->exit_status = status;
-	for (int i=3;i<131;i++)
+	struct thread *leader = thread_current()->leader;
+	enum intr_level old_level = intr_disable();
+	bool first = !leader->exiting;
+
+	leader->exiting = true;
+	intr_set_level(old_level);
+	if (first)
 	{
-		if(thread_current()->fdt[i])
-		{
-			close(i);
-		}
+		printf("%s: exit(%d)\n",thread_name(),status);
+		leader->exit_status = status;
 	}
 	thread_exit();
 }
@@ -189,15 +281,12 @@ int wait(pid_t pid)
 
 bool create (const char *file, unsigned initial_size)
 {
-	lock_acquire(&syn_lock);
 	if (!file)
 	{
 		exit(-1);
 	}
 	//printf("(create: %s)",file);
-	bool temp = filesys_create(file, initial_size);
-	lock_release(&syn_lock);
-	return temp;
+	return filesys_create(file, initial_size);
 }
 
 bool remove (const char *file)
@@ -211,133 +300,427 @@ bool remove (const char *file)
 
 int open (const char *file)
 {
-	lock_acquire(&syn_lock);
 	if (!file)
 	{
-		lock_release(&syn_lock);
 		exit(-1);
 	}
 	struct file *fs = filesys_open(file);
 	//printf("[%s:%p]",file,fs);
 	if(fs)
 	{
-		int i=3;
-		while (i<131)
-		{
-			if(!thread_current()->fdt[i]){
-				int j=0;
-				while (thread_name()[j]==file[j]){
-					if (file[j]=='\0')
-					{
-						file_deny_write(fs);
-						break;
-					}
-					j++;
-				}
-				thread_current()->fdt[i]=fs;
-				lock_release(&syn_lock);
-				return i;
+		int fd;
+		int j=0;
+		while (thread_name()[j]==file[j]){
+			if (file[j]=='\0')
+			{
+				file_deny_write(fs);
+				break;
 			}
-			i++;
+			j++;
 		}
+		fd = fdtable_install(&thread_current()->leader->fdt, fs);
+		if (fd < 0)
+			file_close(fs);
+		return fd;
 	}
-	lock_release(&syn_lock);
 	return -1;
 }
 
 int filesize (int fd)
 {
-	struct file *fs=thread_current()->fdt[fd];
+	struct file *fs=lookup_fd(fd);
+	int ret;
 	if (!fs)
 	{
 		exit(-1);
 	}
-	return file_length(fs);
+	ret = file_length(fs);
+	file_close(fs);
+	return ret;
 }
 
 int read(int fd, void *buffer, unsigned size)
 {
-	int ret=-1;
-	lock_acquire(&syn_lock);
-	pin_vme(buffer, size);
-	if(fd == 0)
+	struct file *fs=NULL;
+	int ret;
+
+	if(fd>2)
 	{
-		unsigned i;
-		for(i = 0; i < size; i++)
+		fs=lookup_fd(fd);
+		if (!fs)
+			exit(-1);
+	}
+	else if(fd!=0)
+		return -1;
+	ret=transfer(fs, buffer, size, -1, true);
+	file_close(fs);
+	return ret;
+}
+
+int write(int fd, const void *buffer, unsigned size)
+{
+	struct file *fs=NULL;
+	int ret;
+
+	if(fd>2)
+	{
+		fs=lookup_fd(fd);
+		if (!fs)
+			exit(-1);
+	}
+	else if(fd!=1)
+		return -1;
+	ret=transfer(fs, (void *) buffer, size, -1, false);
+	file_close(fs);
+	return ret;
+}
+
+/* Reads from FD into the IOVCNT buffers described by the user
+   array IOV.  If the buffers span no more than PIN_MAX bytes'
+   worth of pages, they are all pinned up front and a file is
+   read under a single acquisition of its inode's lock;
+   otherwise they are read one after another. */
+int readv (int fd, const struct iovec *iov, int iovcnt)
+{
+	struct iovec kiov[IOV_MAX];
+	struct file *fs=NULL;
+	int ret=0;
+
+	if (!get_user_iovec(iov, iovcnt, kiov, true))
+		return -1;
+	if (fd>2)
+	{
+		fs=lookup_fd(fd);
+		if (!fs)
+			exit(-1);
+	}
+	else if (fd!=0)
+		return -1;
+	if (iovec_pages(kiov, iovcnt) > PIN_MAX / PGSIZE)
+		ret = transfer_iovec(fs, kiov, iovcnt, true);
+	else
+	{
+		if (!pin_iovec(kiov, iovcnt))
 		{
-			((char *)buffer)[i] = input_getc();
+			file_close(fs);
+			exit(-1);
 		}
-		((char *)buffer)[i] = '\0';
-		ret = size;
+		if (fs)
+			ret = file_readv(fs, kiov, iovcnt);
+		else
+			for (int i = 0; i < iovcnt; i++)
+			{
+				for (size_t j = 0; j < kiov[i].iov_len; j++)
+					((char *)kiov[i].iov_base)[j] = input_getc();
+				ret += kiov[i].iov_len;
+			}
+		unpin_iovec(kiov, iovcnt);
 	}
-	else if(fd>2)
+	file_close(fs);
+	return ret;
+}
+
+/* Writes the IOVCNT buffers described by the user array IOV to
+   FD.  If the buffers span no more than PIN_MAX bytes' worth of
+   pages, a file is written under a single acquisition of its
+   inode's lock, so the write is atomic with respect to other
+   readers and writers of the file; otherwise the buffers are
+   written one after another. */
+int writev (int fd, const struct iovec *iov, int iovcnt)
+{
+	struct iovec kiov[IOV_MAX];
+	struct file *fs=NULL;
+	int ret=0;
+
+	if (!get_user_iovec(iov, iovcnt, kiov, false))
+		return -1;
+	if (fd>2)
 	{
-		struct file *fs=thread_current()->fdt[fd];
+		fs=lookup_fd(fd);
 		if (!fs)
+			exit(-1);
+	}
+	else if (fd!=1)
+		return -1;
+	if (iovec_pages(kiov, iovcnt) > PIN_MAX / PGSIZE)
+		ret = transfer_iovec(fs, kiov, iovcnt, false);
+	else
+	{
+		if (!pin_iovec(kiov, iovcnt))
 		{
+			file_close(fs);
 			exit(-1);
 		}
-		ret=file_read(fs, buffer, size);
+		if (fs)
+			ret = file_writev(fs, kiov, iovcnt);
+		else
+			for (int i = 0; i < iovcnt; i++)
+			{
+				putbuf(kiov[i].iov_base, kiov[i].iov_len);
+				ret += kiov[i].iov_len;
+			}
+		unpin_iovec(kiov, iovcnt);
 	}
-	unpin_vme(buffer, size);
-	lock_release(&syn_lock);
+	file_close(fs);
 	return ret;
 }
 
-int write(int fd, const void *buffer, unsigned size)
+/* Reads SIZE bytes from FD into BUFFER starting at file position
+   OFFSET, without using or changing FD's current position.  Not
+   supported for the console or pipes. */
+int pread (int fd, void *buffer, unsigned size, unsigned offset)
 {
+	struct file *fs;
 	int ret=-1;
-	lock_acquire(&syn_lock);
-	pin_vme(buffer, size);
-	if(fd == 1)
+
+	if (fd<=2 || (int) offset < 0)
+		return -1;
+	fs=lookup_fd(fd);
+	if (!fs)
+		exit(-1);
+	if (!file_is_pipe(fs))
+		ret = transfer(fs, buffer, size, offset, true);
+	file_close(fs);
+	return ret;
+}
+
+/* Writes SIZE bytes from BUFFER to FD starting at file position
+   OFFSET, without using or changing FD's current position.  Not
+   supported for the console or pipes. */
+int pwrite (int fd, const void *buffer, unsigned size, unsigned offset)
+{
+	struct file *fs;
+	int ret=-1;
+
+	if (fd<=2 || (int) offset < 0)
+		return -1;
+	fs=lookup_fd(fd);
+	if (!fs)
+		exit(-1);
+	if (!file_is_pipe(fs))
+		ret = transfer(fs, (void *) buffer, size, offset, false);
+	file_close(fs);
+	return ret;
+}
+
+/* Reads SIZE bytes into the user BUFFER from FS if TO_READ, or
+   writes them from BUFFER to FS otherwise, at file position
+   OFFSET, or at FS's current position if OFFSET is negative.  A
+   null FS stands for the console.  BUFFER must have been checked.
+
+   BUFFER is pinned and transferred at most PIN_MAX bytes at a
+   time, so that a large buffer cannot pin every frame in the
+   user pool.  Stops at the first short transfer, or after the
+   first chunk from a pipe, which returns whatever data is
+   available.  Returns the number of bytes transferred, or -1 if
+   nothing could be written to a pipe.  Kills the process, after
+   dropping the caller's reference to FS, if part of BUFFER has
+   been unmapped by another thread. */
+static int transfer (struct file *fs, void *buffer, unsigned size,
+		     int offset, bool to_read)
+{
+	int done = 0;
+
+	while ((unsigned) done < size)
 	{
-		putbuf(buffer, size);
-		ret = size;
-	}
-	else if(fd>2){
-		struct file *fs=thread_current()->fdt[fd];
-		if (!fs)
+		uint8_t *chunk = (uint8_t *) buffer + done;
+		unsigned len = PIN_MAX - pg_ofs(chunk);
+		int n;
+
+		if (len > size - done)
+			len = size - done;
+		if (!pin_vme(chunk, len))
 		{
+			file_close(fs);
 			exit(-1);
 		}
-		
-		ret= file_write(fs, buffer, size);
+		if (fs == NULL)
+		{
+			if (to_read)
+				for (unsigned i = 0; i < len; i++)
+					chunk[i] = input_getc();
+			else
+				putbuf((const char *) chunk, len);
+			n = len;
+		}
+		else if (offset >= 0)
+			n = to_read ? file_read_at(fs, chunk, len, offset + done)
+				: file_write_at(fs, chunk, len, offset + done);
+		else
+			n = to_read ? file_read(fs, chunk, len)
+				: file_write(fs, chunk, len);
+		unpin_vme(chunk, len);
+
+		if (n < 0)
+		{
+			if (done == 0)
+				done = -1;
+			break;
+		}
+		done += n;
+		if ((unsigned) n < len || (fs != NULL && file_is_pipe(fs)))
+			break;
 	}
-	unpin_vme(buffer, size);
-	lock_release(&syn_lock);
-	return ret;
+	return done;
+}
+
+/* Does transfer() on each of the IOVCNT buffers described by IOV
+   in turn, stopping at the first short one. */
+static int transfer_iovec (struct file *fs, const struct iovec *iov,
+			   int iovcnt, bool to_read)
+{
+	int done = 0;
+
+	for (int i = 0; i < iovcnt; i++)
+	{
+		int n;
+
+		if (iov[i].iov_len == 0)
+			continue;
+		n = transfer(fs, iov[i].iov_base, iov[i].iov_len, -1, to_read);
+		if (n < 0)
+		{
+			if (done == 0)
+				done = -1;
+			break;
+		}
+		done += n;
+		if ((size_t) n < iov[i].iov_len
+		    || (fs != NULL && file_is_pipe(fs)))
+			break;
+	}
+	return done;
+}
+
+/* Returns the number of pages spanned by the IOVCNT buffers
+   described by IOV, counting a page once per buffer in it. */
+static size_t iovec_pages (const struct iovec *iov, int iovcnt)
+{
+	size_t pages = 0;
+
+	for (int i = 0; i < iovcnt; i++)
+		if (iov[i].iov_len > 0)
+		{
+			uint8_t *base = iov[i].iov_base;
+			pages += pg_no(base + iov[i].iov_len - 1) - pg_no(base) + 1;
+		}
+	return pages;
+}
+
+/* Copies the IOVCNT-element I/O vector at user address UIOV into
+   KIOV, which has room for IOV_MAX elements, and checks each page
+   of the buffers it describes, which must be writable if
+   TO_WRITE.  Returns false if IOVCNT is out of range or the
+   buffers total more than INT_MAX bytes.  Kills the process if
+   any of the memory involved is invalid. */
+static bool get_user_iovec (const struct iovec *uiov, int iovcnt,
+			    struct iovec *kiov, bool to_write)
+{
+	void *esp = thread_current()->syscall_esp;
+	size_t total = 0;
+
+	if (iovcnt < 0 || iovcnt > IOV_MAX)
+		return false;
+	if (copy_from_user(kiov, uiov, iovcnt * sizeof *kiov) != 0)
+		exit(-1);
+	for (int i = 0; i < iovcnt; i++)
+	{
+		if (kiov[i].iov_len > INT_MAX - total)
+			return false;
+		total += kiov[i].iov_len;
+		check_valid_buffer(kiov[i].iov_base, kiov[i].iov_len, esp, to_write);
+	}
+	return true;
+}
+
+/* Pins the buffers of the IOVCNT-element vector IOV.  Returns
+   false, with none of them pinned, if any cannot be. */
+static bool pin_iovec (const struct iovec *iov, int iovcnt)
+{
+	for (int i = 0; i < iovcnt; i++)
+		if (!pin_vme(iov[i].iov_base, iov[i].iov_len))
+		{
+			unpin_iovec(iov, i);
+			return false;
+		}
+	return true;
+}
+
+static void unpin_iovec (const struct iovec *iov, int iovcnt)
+{
+	for (int i = 0; i < iovcnt; i++)
+		unpin_vme(iov[i].iov_base, iov[i].iov_len);
+}
+
+/* Returns the file open as FD in the current process, or a null
+   pointer if there is none.  The caller must drop the returned
+   reference with file_close() once it is done with the file. */
+static struct file *lookup_fd (int fd)
+{
+	return fdtable_get(&thread_current()->leader->fdt, fd);
+}
+
+/* Creates a pipe and stores the file descriptors of its read and
+   write ends into FDS[0] and FDS[1]. */
+bool pipe (int fds[2])
+{
+	struct fdtable *fdt = &thread_current()->leader->fdt;
+	struct file *r, *w;
+	int i, j;
+
+	if (!pipe_create(&r, &w))
+		return false;
+	i = fdtable_install(fdt, r);
+	j = i >= 0 ? fdtable_install(fdt, w) : -1;
+	if (j < 0)
+	{
+		if (i >= 0)
+			fdtable_remove(fdt, i);
+		file_close(r);
+		file_close(w);
+		return false;
+	}
+	if (copy_to_user(&fds[0], &i, sizeof i) != 0
+	    || copy_to_user(&fds[1], &j, sizeof j) != 0)
+		exit(-1);
+	return true;
 }
 
 void seek (int fd, unsigned position)
 {
-	struct file *fs=thread_current()->fdt[fd];
+	struct file *fs=lookup_fd(fd);
 	if (!fs)
 	{
 		exit(-1);
 	}
 	file_seek(fs, position);
+	file_close(fs);
 }
 
 unsigned tell (int fd)
 {
-	struct file *fs=thread_current()->fdt[fd];
+	struct file *fs=lookup_fd(fd);
+	unsigned ret;
 	if (!fs)
 	{
 		exit(-1);
 	}
-	return file_tell(fs);
+	ret = file_tell(fs);
+	file_close(fs);
+	return ret;
 }
 
 void close (int fd)
 {
 	//printf("{close: %d}",fd);
-	struct file *fs=thread_current()->fdt[fd];
+	/* Drops only the table's reference; a system call still using
+	   the file in another thread keeps it open until it is done. */
+	struct file *fs=fdtable_remove(&thread_current()->leader->fdt, fd);
 	if (!fs)
 	{
 		exit(-1);
 	}
 	file_close(fs);
-	thread_current()->fdt[fd]=NULL;
 }
 
 int fibonacci(int n)
@@ -363,4 +746,53 @@ int max_of_four_int(int a, int b, int c, int d)
 	if(d>a)
 		a=d;
 	return a;
-}
\ No newline at end of file
+}
+
+bool schedstat (pid_t pid, struct schedstat *st)
+{
+	struct schedstat copy;
+
+	/* PID 0 names the calling process. */
+	if (pid == 0)
+		pid = thread_tid();
+	if (!thread_get_schedstat(pid, &copy))
+		return false;
+	if (copy_to_user(st, &copy, sizeof copy) != 0)
+		exit(-1);
+	return true;
+}
+
+bool vmstat (struct vmstat *st)
+{
+	struct vmstat copy;
+
+	frame_get_stats(&copy);
+	if (copy_to_user(st, &copy, sizeof copy) != 0)
+		exit(-1);
+	return true;
+}
+
+bool set_tickets (int tickets)
+{
+	return thread_set_tickets(tickets);
+}
+
+bool set_deadline (int runtime, int deadline, int period)
+{
+	return thread_set_deadline(runtime, deadline, period);
+}
+
+int sys_thread_create (void (*start)(void), void (*func)(void *), void *aux)
+{
+	return process_thread_create(start, func, aux);
+}
+
+bool sys_thread_join (int tid)
+{
+	return process_thread_join(tid);
+}
+
+void sys_thread_exit (void)
+{
+	process_thread_exit();
+}
@@ -4,10 +4,11 @@
 #include "vm/page.h"
 #include "lib/user/syscall.h"
 
+struct intr_frame;
+
 void syscall_init(void);
-void check_user(int *, int);
+void syscall_handler(struct intr_frame *);
+void check_user(int *, const int *, int);
 struct vm_entry *check_address(void *, void *);
-void check_valid_string (void *, void *);
-void check_valid_strlen (void *, unsigned, void *);
 void check_valid_buffer (void *, unsigned, void *, bool);
 #endif /* userprog/syscall.h */
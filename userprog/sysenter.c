@@ -0,0 +1,62 @@
+#include "userprog/sysenter.h"
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/loader.h"
+#include "userprog/tss.h"
+
+/* Model-specific registers that SYSENTER loads the kernel's code
+   segment, stack pointer, and entry point from. */
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
+
+/* In sysenter-stub.S. */
+void sysenter_entry (void);
+
+/* Writes VALUE to model-specific register MSR. */
+static inline void
+wrmsr (uint32_t msr, uint64_t value)
+{
+  asm volatile ("wrmsr" : : "c" (msr), "A" (value));
+}
+
+/* Returns true if the CPU supports SYSENTER and SYSEXIT.
+
+   The Pentium Pro reports support in CPUID but does not actually
+   implement the instructions, so it is excluded by model.  User
+   programs make the same check before using SYSENTER (see
+   lib/user/syscall.c). */
+bool
+sysenter_supported (void)
+{
+  uint32_t eax, ebx, ecx, edx;
+  unsigned family, model, stepping;
+
+  asm ("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1));
+  family = (eax >> 8) & 0xf;
+  model = (eax >> 4) & 0xf;
+  stepping = eax & 0xf;
+  if (!(edx & (1u << 11)))
+    return false;
+  return !(family == 6 && model < 3 && stepping < 3);
+}
+
+/* Sets up the fast system call entry path, if the CPU has one.
+
+   SYSENTER loads the stack pointer from an MSR, but each thread
+   has its own kernel stack.  Rather than rewriting the MSR on
+   every context switch, we point it at the TSS's ring 0 stack
+   pointer, which tss_update() keeps current, and sysenter_entry
+   loads the real stack pointer from there. */
+void
+sysenter_init (void)
+{
+  if (!sysenter_supported ())
+    {
+      printf ("sysenter: not supported, using int $0x30 only\n");
+      return;
+    }
+  wrmsr (MSR_SYSENTER_CS, SEL_KCSEG);
+  wrmsr (MSR_SYSENTER_ESP, (uint32_t) tss_esp0 ());
+  wrmsr (MSR_SYSENTER_EIP, (uint32_t) sysenter_entry);
+}
@@ -0,0 +1,9 @@
+#ifndef USERPROG_SYSENTER_H
+#define USERPROG_SYSENTER_H
+
+#include <stdbool.h>
+
+bool sysenter_supported (void);
+void sysenter_init (void);
+
+#endif /* userprog/sysenter.h */
@@ -0,0 +1,115 @@
+#include "userprog/uaccess.h"
+#include <stdint.h>
+#include "threads/interrupt.h"
+#include "threads/vaddr.h"
+
+/* An exception table entry: if the instruction at INSN faults,
+   resume at FIXUP.  The linker script gathers the entries that
+   EX_TABLE_ENTRY emits into one array, between _start_ex_table
+   and _end_ex_table. */
+struct ex_entry
+  {
+    uintptr_t insn;
+    uintptr_t fixup;
+  };
+
+extern const struct ex_entry _start_ex_table[], _end_ex_table[];
+
+/* Assembler text that adds an exception table entry for the
+   instruction at label INSN with fixup at label FIXUP. */
+#define EX_TABLE_ENTRY(INSN, FIXUP)                     \
+        ".section __ex_table, \"a\"\n\t"                \
+        ".long " INSN ", " FIXUP "\n\t"                 \
+        ".previous\n\t"
+
+/* Copies SIZE bytes from user address USRC to kernel address DST.
+   Returns the number of bytes that could not be copied, so 0 on
+   success. */
+size_t
+copy_from_user (void *dst, const void *usrc, size_t size)
+{
+  if (!is_user_range (usrc, size))
+    return size;
+
+  /* A fault leaves the count of bytes not yet copied in %ecx. */
+  asm volatile ("1: rep movsb\n"
+                "2:\n\t"
+                EX_TABLE_ENTRY ("1b", "2b")
+                : "+c" (size), "+D" (dst), "+S" (usrc)
+                : : "memory");
+  return size;
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address UDST.
+   Returns the number of bytes that could not be copied, so 0 on
+   success. */
+size_t
+copy_to_user (void *udst, const void *src, size_t size)
+{
+  if (!is_user_range (udst, size))
+    return size;
+
+  asm volatile ("1: rep movsb\n"
+                "2:\n\t"
+                EX_TABLE_ENTRY ("1b", "2b")
+                : "+c" (size), "+D" (udst), "+S" (src)
+                : : "memory");
+  return size;
+}
+
+/* Reads a byte at user address UADDR.  Returns the byte value if
+   successful, -1 if UADDR cannot be read. */
+static inline int
+get_user (const uint8_t *uaddr)
+{
+  int result;
+
+  if (!is_user_range (uaddr, 1))
+    return -1;
+  asm volatile ("1: movzbl %1, %0\n\t"
+                "jmp 3f\n"
+                "2: movl $-1, %0\n"
+                "3:\n\t"
+                EX_TABLE_ENTRY ("1b", "2b")
+                : "=r" (result) : "m" (*uaddr));
+  return result;
+}
+
+/* Copies the null-terminated string at user address USRC into
+   DST, which has room for SIZE bytes.  Returns the length of the
+   string, not counting the null terminator, if it fits; SIZE if
+   it does not fit, in which case DST is not null-terminated; or
+   -1 if USRC cannot be read. */
+int
+strncpy_from_user (char *dst, const char *usrc, size_t size)
+{
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    {
+      int c = get_user ((const uint8_t *) usrc + i);
+      if (c < 0)
+        return -1;
+      dst[i] = c;
+      if (c == '\0')
+        return i;
+    }
+  return size;
+}
+
+/* If the kernel instruction that faulted with interrupt frame F
+   has an exception table entry, redirects F to resume at its
+   fixup and returns true.  Otherwise returns false. */
+bool
+uaccess_fixup (struct intr_frame *f)
+{
+  const struct ex_entry *e;
+
+  for (e = _start_ex_table; e < _end_ex_table; e++)
+    if (e->insn == (uintptr_t) f->eip)
+      {
+        f->eip = (void (*) (void)) e->fixup;
+        return true;
+      }
+  return false;
+}
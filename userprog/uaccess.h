@@ -0,0 +1,26 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Access to user memory from the kernel.
+
+   These functions touch user memory directly, so that a page
+   that is not present is brought in by the page fault handler
+   as usual.  An access that the page fault handler cannot
+   satisfy, because the address is unmapped or the page is
+   read-only, does not kill the process; instead, page_fault()
+   finds the faulting instruction in the exception table and
+   resumes at its fixup, which makes the function return an
+   error. */
+
+struct intr_frame;
+
+size_t copy_from_user (void *dst, const void *usrc, size_t size);
+size_t copy_to_user (void *udst, const void *src, size_t size);
+int strncpy_from_user (char *dst, const char *usrc, size_t size);
+
+bool uaccess_fixup (struct intr_frame *);
+
+#endif /* userprog/uaccess.h */
@@ -0,0 +1,172 @@
+#include "vm/frame.h"
+#include <list.h>
+
+/* Adaptive Replacement Cache, in the form that works from
+   reference bits instead of seeing every access: CAR ("CAR:
+   Clock with Adaptive Replacement", Bansal and Modha, FAST '04).
+
+   Resident pages are on one of two clocks, here lists whose
+   front is the clock hand.  T1 holds pages that have been
+   faulted in once; T2 holds pages that were referenced again
+   while on T1, or that were faulted back in soon after being
+   evicted.  B1 and B2 remember the pages most recently evicted
+   from T1 and T2 through their vm_entries.  A fault on a page in
+   B1 means T1 is too small and moves the target size P for T1
+   up; a fault on a page in B2 moves it down.  A page that is
+   only ever scanned once passes through T1 and never pushes a
+   T2 page out of memory unless P says T1 needs the room. */
+
+enum arc_list
+  {
+    ARC_NONE,
+    ARC_T1,             /* Resident, seen once. */
+    ARC_T2,             /* Resident, seen twice or more. */
+    ARC_B1,             /* Evicted from T1. */
+    ARC_B2,             /* Evicted from T2. */
+    ARC_LIST_CNT
+  };
+
+static struct list lists[ARC_LIST_CNT];
+static size_t counts[ARC_LIST_CNT];
+
+static size_t cache_size;       /* Number of frames, "c". */
+static size_t t1_target;        /* Target size of T1, "p". */
+
+/* Appends VME to the back of list L. */
+static void push(struct vm_entry *vme, enum arc_list l)
+{
+    list_push_back(&lists[l], &vme->policy_elem);
+    vme->policy_list = l;
+    counts[l]++;
+}
+
+/* Removes VME from its list. */
+static void take(struct vm_entry *vme)
+{
+    ASSERT(vme->policy_list != ARC_NONE);
+    list_remove(&vme->policy_elem);
+    counts[vme->policy_list]--;
+    vme->policy_list = ARC_NONE;
+}
+
+/* Returns the vm_entry at the front of nonempty list L. */
+static struct vm_entry *front(enum arc_list l)
+{
+    return list_entry(list_front(&lists[l]), struct vm_entry, policy_elem);
+}
+
+static size_t max_size(size_t a, size_t b)
+{
+    return a > b ? a : b;
+}
+
+static void arc_init(size_t frame_cnt)
+{
+    int i;
+
+    for (i = 0; i < ARC_LIST_CNT; i++){
+        list_init(&lists[i]);
+        counts[i] = 0;
+    }
+    cache_size = frame_cnt;
+    t1_target = 0;
+}
+
+static void arc_insert(struct page *page)
+{
+    struct vm_entry *vme = page->vme;
+    size_t delta;
+
+    switch (vme->policy_list)
+    {
+        case ARC_B1:
+            delta = max_size(1, counts[ARC_B2] / counts[ARC_B1]);
+            t1_target = t1_target + delta < cache_size
+                        ? t1_target + delta : cache_size;
+            take(vme);
+            push(vme, ARC_T2);
+            break;
+        case ARC_B2:
+            delta = max_size(1, counts[ARC_B1] / counts[ARC_B2]);
+            t1_target = t1_target > delta ? t1_target - delta : 0;
+            take(vme);
+            push(vme, ARC_T2);
+            break;
+        default:
+            ASSERT(vme->policy_list == ARC_NONE);
+            push(vme, ARC_T1);
+            break;
+    }
+}
+
+static void arc_remove(struct page *page, bool evicted)
+{
+    struct vm_entry *vme = page->vme;
+    enum arc_list from = vme->policy_list;
+
+    take(vme);
+    if (!evicted)
+        return;
+
+    /* Remember the page, then keep the history no bigger than
+       the cache for B1 and twice the cache overall. */
+    push(vme, from == ARC_T1 ? ARC_B1 : ARC_B2);
+    while (counts[ARC_T1] + counts[ARC_B1] > cache_size)
+        take(front(ARC_B1));
+    while (counts[ARC_T1] + counts[ARC_T2] + counts[ARC_B1] + counts[ARC_B2]
+           > 2 * cache_size)
+        take(front(counts[ARC_B2] > 0 ? ARC_B2 : ARC_B1));
+}
+
+static struct page *arc_victim(void)
+{
+    /* Pinned pages passed over on each clock since a referenced
+       page was last moved.  In between, the clocks only rotate
+       pinned pages, so once a whole clock has been passed over,
+       every page on it is pinned and the other one has to give up
+       a page. */
+    size_t pinned[ARC_LIST_CNT] = {0};
+
+    for (;;){
+        enum arc_list l;
+        struct vm_entry *vme;
+
+        if (pinned[ARC_T1] >= counts[ARC_T1]
+            && pinned[ARC_T2] >= counts[ARC_T2])
+            return NULL;
+        if ((counts[ARC_T1] >= max_size(1, t1_target)
+             || pinned[ARC_T2] >= counts[ARC_T2])
+            && pinned[ARC_T1] < counts[ARC_T1])
+            l = ARC_T1;
+        else
+            l = ARC_T2;
+        vme = front(l);
+
+        /* A referenced page on either clock moves to the back of
+           T2 with its reference bit cleared.  A pinned page, or
+           one still being loaded, just goes around again. */
+        if (!frame_evictable(vme->page)){
+            take(vme);
+            push(vme, l);
+            pinned[l]++;
+        }
+        else if (frame_referenced(vme->page)){
+            take(vme);
+            push(vme, ARC_T2);
+            pinned[ARC_T1] = pinned[ARC_T2] = 0;
+        }
+        else
+            return vme->page;
+    }
+}
+
+static void arc_forget(struct vm_entry *vme)
+{
+    if (vme->policy_list != ARC_NONE)
+        take(vme);
+}
+
+const struct frame_policy arc_policy =
+  {
+    "arc", arc_init, arc_insert, arc_remove, arc_victim, arc_forget,
+  };
@@ -0,0 +1,270 @@
+#include "vm/frame.h"
+#include <list.h>
+
+/* CLOCK-Pro ("CLOCK-Pro: An Effective Improvement of the CLOCK
+   Replacement", Jiang, Chen and Zhang, USENIX '05).
+
+   Pages are hot or cold.  All resident pages, plus cold pages
+   that were evicted recently, sit on a single circular list in
+   order of their last access, newest just behind HAND_HOT.  A
+   newly faulted page starts out cold and in its "test period".
+   If it is referenced again while the test period lasts, its
+   reuse distance is short enough for it to become hot.  Only
+   cold pages are ever evicted, so a page that is scanned once
+   stays cold and cannot push hot pages out of memory.
+
+   Three hands move around the list:
+
+     - HAND_COLD looks for a victim among the resident cold
+       pages.  It promotes referenced cold pages in their test
+       period and gives other referenced cold pages a new one.
+
+     - HAND_HOT demotes unreferenced hot pages to cold when there
+       are too many hot pages, and ends the test period of the
+       cold pages it passes.
+
+     - HAND_TEST ends test periods and drops evicted pages when
+       too many evicted pages are remembered.
+
+   The number of frames set aside for cold pages adapts: it grows
+   when an evicted page is faulted back in during its test
+   period, and shrinks when a test period ends unused. */
+
+/* vm_entry policy_flags. */
+#define CP_HOT 0x1              /* Hot page. */
+#define CP_TEST 0x2             /* Cold page in its test period. */
+
+/* vm_entry policy_list: on the clock. */
+#define CP_ON_CLOCK 1
+
+static struct list clock;
+static struct list_elem *hand_hot, *hand_cold, *hand_test;
+
+static size_t mem_size;         /* Number of frames, "m". */
+static size_t cold_target;      /* Frames for cold pages, "m_c". */
+static size_t hot_cnt;          /* Resident hot pages. */
+static size_t cold_cnt;         /* Resident cold pages. */
+static size_t nonres_cnt;       /* Evicted pages still on the clock. */
+
+static struct vm_entry *entry(struct list_elem *e)
+{
+    return list_entry(e, struct vm_entry, policy_elem);
+}
+
+/* Returns the element after E on the circular clock. */
+static struct list_elem *next(struct list_elem *e)
+{
+    e = list_next(e);
+    return e != list_end(&clock) ? e : list_begin(&clock);
+}
+
+/* Puts VME at the head of the clock, that is, just behind
+   HAND_HOT, so that every hand reaches it last. */
+static void clock_link(struct vm_entry *vme)
+{
+    if (list_empty(&clock)){
+        list_push_back(&clock, &vme->policy_elem);
+        hand_hot = hand_cold = hand_test = &vme->policy_elem;
+    }
+    else
+        list_insert(hand_hot, &vme->policy_elem);
+    vme->policy_list = CP_ON_CLOCK;
+}
+
+/* Takes VME off the clock, moving any hand that points to it
+   on to the next element. */
+static void clock_unlink(struct vm_entry *vme)
+{
+    struct list_elem *e = &vme->policy_elem;
+    struct list_elem *n = next(e);
+
+    list_remove(e);
+    if (list_empty(&clock))
+        hand_hot = hand_cold = hand_test = NULL;
+    else{
+        if (hand_hot == e)
+            hand_hot = n;
+        if (hand_cold == e)
+            hand_cold = n;
+        if (hand_test == e)
+            hand_test = n;
+    }
+    vme->policy_list = 0;
+}
+
+static bool resident(const struct vm_entry *vme)
+{
+    return frame_resident(vme);
+}
+
+/* Ends the test period of cold page VME, which then leaves the
+   clock if it is not resident. */
+static void end_test(struct vm_entry *vme)
+{
+    vme->policy_flags &= ~CP_TEST;
+    if (cold_target > 1)
+        cold_target--;
+    if (!resident(vme)){
+        clock_unlink(vme);
+        nonres_cnt--;
+    }
+}
+
+/* Runs HAND_HOT until no more than the target number of frames
+   hold hot pages. */
+static void run_hand_hot(void)
+{
+    while (hot_cnt > 0 && hot_cnt > mem_size - cold_target){
+        struct vm_entry *vme = entry(hand_hot);
+
+        hand_hot = next(hand_hot);
+        if (vme->policy_flags & CP_HOT){
+            if (!frame_referenced(vme->page)){
+                vme->policy_flags = 0;
+                hot_cnt--;
+                cold_cnt++;
+            }
+        }
+        else if (vme->policy_flags & CP_TEST)
+            end_test(vme);
+    }
+}
+
+/* Runs HAND_TEST until no more evicted pages are remembered than
+   there are frames. */
+static void run_hand_test(void)
+{
+    while (nonres_cnt > mem_size){
+        struct vm_entry *vme = entry(hand_test);
+
+        hand_test = next(hand_test);
+        if (vme->policy_flags & CP_TEST)
+            end_test(vme);
+    }
+}
+
+/* Moves HAND_HOT on to the next unreferenced hot page, which
+   there must be at least one of, and demotes it to cold. */
+static void demote_hot(void)
+{
+    for (;;){
+        struct vm_entry *vme = entry(hand_hot);
+
+        hand_hot = next(hand_hot);
+        if ((vme->policy_flags & CP_HOT) && !frame_referenced(vme->page)){
+            vme->policy_flags = 0;
+            hot_cnt--;
+            cold_cnt++;
+            return;
+        }
+    }
+}
+
+static void clockpro_init(size_t frame_cnt)
+{
+    list_init(&clock);
+    hand_hot = hand_cold = hand_test = NULL;
+    mem_size = frame_cnt;
+    cold_target = frame_cnt / 4 > 1 ? frame_cnt / 4 : 1;
+    hot_cnt = cold_cnt = nonres_cnt = 0;
+}
+
+static void clockpro_insert(struct page *page)
+{
+    struct vm_entry *vme = page->vme;
+
+    if (vme->policy_list == CP_ON_CLOCK){
+        /* Faulted back in during its test period: the page's
+           reuse distance is short, and there were too few cold
+           frames to keep it. */
+        clock_unlink(vme);
+        nonres_cnt--;
+        if (cold_target < mem_size - 1)
+            cold_target++;
+        vme->policy_flags = CP_HOT;
+        clock_link(vme);
+        hot_cnt++;
+        run_hand_hot();
+    }
+    else{
+        vme->policy_flags = CP_TEST;
+        clock_link(vme);
+        cold_cnt++;
+    }
+}
+
+static void clockpro_remove(struct page *page, bool evicted)
+{
+    struct vm_entry *vme = page->vme;
+
+    if (vme->policy_flags & CP_HOT)
+        hot_cnt--;
+    else
+        cold_cnt--;
+
+    if (evicted && vme->policy_flags == CP_TEST){
+        /* Stay on the clock for the rest of the test period. */
+        if (hand_cold == &vme->policy_elem)
+            hand_cold = next(hand_cold);
+        nonres_cnt++;
+        run_hand_test();
+    }
+    else{
+        clock_unlink(vme);
+        vme->policy_flags = 0;
+    }
+}
+
+static struct page *clockpro_victim(void)
+{
+    /* Entries HAND_COLD has passed without finding a victim.  Once
+       it has gone all the way around, every resident cold page is
+       pinned, so a hot page has to become cold. */
+    size_t passed = 0;
+
+    for (;;){
+        struct vm_entry *vme;
+
+        if (cold_cnt == 0 || passed > hot_cnt + cold_cnt + nonres_cnt){
+            if (hot_cnt == 0)
+                return NULL;
+            demote_hot();
+            passed = 0;
+        }
+        passed++;
+        vme = entry(hand_cold);
+
+        hand_cold = next(hand_cold);
+        if ((vme->policy_flags & CP_HOT) || !resident(vme)
+            || !frame_evictable(vme->page))
+            continue;
+        if (!frame_referenced(vme->page))
+            return vme->page;
+
+        clock_unlink(vme);
+        if (vme->policy_flags & CP_TEST){
+            /* Reused during its test period. */
+            vme->policy_flags = CP_HOT;
+            cold_cnt--;
+            hot_cnt++;
+        }
+        else
+            vme->policy_flags = CP_TEST;
+        clock_link(vme);
+        run_hand_hot();
+    }
+}
+
+static void clockpro_forget(struct vm_entry *vme)
+{
+    if (vme->policy_list == CP_ON_CLOCK){
+        clock_unlink(vme);
+        nonres_cnt--;
+    }
+}
+
+const struct frame_policy clockpro_policy =
+  {
+    "clockpro", clockpro_init, clockpro_insert, clockpro_remove,
+    clockpro_victim, clockpro_forget,
+  };
@@ -1,108 +1,471 @@
 #include "vm/frame.h"
+#include <inttypes.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
 #include "userprog/pagedir.h"
 #include "threads/malloc.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 
-static void move_lru_clock(void)
+/* Protects the frame table, the replacement policy and the
+   statistics below. */
+struct lock frame_lock;
+
+/* Frame table: one frame descriptor per page of the user pool,
+   indexed by page number within the pool, so that finding the
+   descriptor for a kernel address takes constant time and
+   faulting a page in does not allocate memory. */
+static struct page *frames;
+static size_t frame_cnt;
+static uint8_t *frame_base;
+
+/* Clock hand: index of the next frame to consider for eviction. */
+static size_t clock_hand;
+
+static struct lockstat frame_lockstat;
+
+/* Statistics, protected by frame_lock. */
+static struct vmstat stats;
+
+/* Free frame watermarks.  The page-out daemon wakes up when fewer
+   than free_low frames are free, and evicts pages until free_high
+   frames are, so that faults normally find a free frame without
+   waiting for a page to be written to swap. */
+static size_t free_low, free_high;
+static size_t free_cnt;                 /* Free frames. */
+static struct condition pageout_wait;   /* Daemon waits for work here. */
+static struct condition frames_freed;   /* Stalled allocators wait here. */
+
+static thread_func pageout_daemon NO_RETURN;
+
+static void clock_init(size_t);
+static void clock_insert(struct page *);
+static void clock_remove(struct page *, bool);
+static struct page* clock_victim(void);
+static void clock_forget(struct vm_entry *);
+
+/* Second-chance clock over the frame table.  It keeps no state
+   besides the clock hand. */
+static const struct frame_policy clock_policy =
+  {
+    "clock", clock_init, clock_insert, clock_remove, clock_victim,
+    clock_forget,
+  };
+
+/* Policies selectable with -vmpolicy, default first. */
+static const struct frame_policy *const policies[] =
+  {
+    &clock_policy, &clockpro_policy, &arc_policy,
+  };
+
+/* Page replacement policy in use. */
+static const struct frame_policy *policy = &clock_policy;
+
+/* Selects the page replacement policy called NAME.  Must be
+   called before frame_table_init().  Returns false if there is
+   no such policy. */
+bool frame_set_policy(const char *name)
 {
-    if (list_empty(&lru_list))
-        lru_clock = NULL;
-    else if (!lru_clock || list_end(&lru_list) == lru_clock || list_end(&lru_list) == list_next(lru_clock))
-        lru_clock = list_begin(&lru_list);
-    else
-        lru_clock = list_next(lru_clock);
+    size_t i;
+
+    for (i = 0; i < sizeof policies / sizeof *policies; i++)
+        if (!strcmp(name, policies[i]->name)){
+            policy = policies[i];
+            return true;
+        }
+    return false;
 }
 
-void lru_list_init(void)
+/* Returns the frame descriptor for KADDR, or a null pointer if
+   KADDR is not a page in the user pool. */
+static struct page* frame_of(void* kaddr)
 {
-    list_init(&lru_list);
-    lock_init(&lru_list_lock);
-    lru_clock = NULL;
+    size_t idx;
+
+    if ((uint8_t *) kaddr < frame_base)
+        return NULL;
+    idx = pg_no(kaddr) - pg_no(frame_base);
+    return idx < frame_cnt ? &frames[idx] : NULL;
 }
 
-void add_page_to_lru_list(struct page* page)
+void frame_table_init(void)
 {
-    list_push_back(&lru_list, &page->lru);
+    void *base;
+    size_t pages, i;
+
+    frame_cnt = palloc_user_pool(&base);
+    frame_base = base;
+    pages = DIV_ROUND_UP(frame_cnt * sizeof *frames, PGSIZE);
+    frames = palloc_get_multiple(PAL_ASSERT | PAL_ZERO, pages);
+    for (i = 0; i < frame_cnt; i++)
+        cond_init(&frames[i].transit);
+    lock_init(&frame_lock);
+    lock_profile(&frame_lock, &frame_lockstat, "frame table");
+    cond_init(&pageout_wait);
+    cond_init(&frames_freed);
+    policy->init(frame_cnt);
+
+    free_cnt = frame_cnt;
+    free_low = frame_cnt / 64 > SWAP_BATCH ? frame_cnt / 64 : SWAP_BATCH;
+    free_high = 2 * free_low;
+    if (free_high > frame_cnt / 2){
+        free_high = frame_cnt / 2;
+        free_low = free_high / 2;
+    }
 }
 
-void del_page_from_lru_list(struct page* page)
+/* Starts the page-out daemon.  Must be called after swap_init(). */
+void frame_start_pageout(void)
 {
-    if(lru_clock == &page->lru)
-        move_lru_clock();
-    list_remove(&page->lru);
+    if (thread_create("pageout", PRI_DEFAULT, pageout_daemon, NULL)
+        == TID_ERROR)
+        PANIC("can't start page-out daemon");
 }
 
-struct page* alloc_page(enum palloc_flags flags)
+/* Page-out daemon.  Sleeps until free frames run low, then evicts
+   batches of pages until there are enough again. */
+static void pageout_daemon(void *aux UNUSED)
+{
+    lock_acquire(&frame_lock);
+    for (;;){
+        while (free_cnt >= free_low)
+            cond_wait(&pageout_wait, &frame_lock);
+
+        while (free_cnt < free_high){
+            if (try_to_free_pages(PAL_USER) == 0){
+                /* Everything is pinned.  frame_unpin() wakes us up
+                   once a page can be evicted again. */
+                cond_wait(&pageout_wait, &frame_lock);
+                break;
+            }
+
+            /* Let stalled allocators take the frames before the
+               next batch. */
+            cond_broadcast(&frames_freed, &frame_lock);
+            lock_release(&frame_lock);
+            thread_yield();
+            lock_acquire(&frame_lock);
+        }
+    }
+}
+
+/* Allocates a user frame for VME and returns its descriptor.
+   If no frame is free, waits for the page-out daemon to evict
+   some.  The frame cannot be evicted until frame_installed() is
+   called on it.
+
+   If VME's page is already in a frame that another thread is
+   loading, or that is being written to swap, first waits for
+   that to finish.  Returns a null pointer if the page turns out
+   to be mapped by then. */
+struct page* alloc_page(enum palloc_flags flags, struct vm_entry *vme)
 {
-    lock_acquire(&lru_list_lock);
+    ASSERT(flags & PAL_USER);
+
+    lock_acquire(&frame_lock);
+
+    while (vme->page != NULL && vme->page->state != FRAME_MAPPED)
+        cond_wait(&vme->page->transit, &frame_lock);
+    if (vme->page != NULL){
+        lock_release(&frame_lock);
+        return NULL;
+    }
     
     uint8_t *kpage = palloc_get_page(flags);
-    while (!kpage){
-        try_to_free_pages(flags);
-        kpage = palloc_get_page(flags);
+    if (!kpage){
+        int64_t start = timer_ticks();
+
+        stats.stall_cnt++;
+        do{
+            cond_signal(&pageout_wait, &frame_lock);
+            cond_wait(&frames_freed, &frame_lock);
+            kpage = palloc_get_page(flags);
+        } while (!kpage);
+        stats.stall_ticks += timer_elapsed(start);
     }
+    if (--free_cnt < free_low)
+        cond_signal(&pageout_wait, &frame_lock);
 
-    struct page *pg = malloc(sizeof(struct page));
-    pg->thread = thread_current();
+    struct page *pg = frame_of(kpage);
+    ASSERT(pg != NULL && pg->kaddr == NULL);
+    pg->thread = thread_current()->leader;
+    pg->vme = vme;
     pg->kaddr = kpage;
-    add_page_to_lru_list(pg);
+    pg->state = FRAME_LOADING;
+    vme->page = pg;
+    policy->insert(pg);
+    stats.fault_cnt++;
 
-    lock_release(&lru_list_lock);
+    lock_release(&frame_lock);
     return pg;
 }
 
+/* Frees the user page at KADDR.  Does nothing if KADDR is not
+   an allocated user page, which includes a null pointer. */
 void free_page(void* kaddr)
 {
-    lock_acquire(&lru_list_lock);
+    lock_acquire(&frame_lock);
     
-    struct list_elem *e;
-    struct page *target = NULL;
-
-    for (e = list_begin(&lru_list); e != list_end(&lru_list); e = list_next(e)){
-        struct page *pg = list_entry(e, struct page, lru);
-        if(kaddr == pg->kaddr){
-            target = pg;
-            break;
-        }
+    struct page *target = frame_of(kaddr);
+    if(target && target->kaddr){
+        ASSERT(target->state != FRAME_IN_TRANSIT);
+        __free_page(target, false);
     }
-    if(target)
-        __free_page(target);
-    lock_release(&lru_list_lock);
+    lock_release(&frame_lock);
 }
 
-void __free_page(struct page* page)
+/* Returns PAGE, which its vm_entry no longer refers to, to the
+   user pool. */
+static void release_frame(struct page *page)
 {
-    del_page_from_lru_list(page);
-    pagedir_clear_page(page->thread->pagedir, pg_round_down(page->vme->vaddr));
     palloc_free_page(page->kaddr);
-    free(page);
+    page->kaddr = NULL;
+    page->vme = NULL;
+    page->thread = NULL;
+    free_cnt++;
+    cond_broadcast(&page->transit, &frame_lock);
+    cond_broadcast(&frames_freed, &frame_lock);
 }
 
-void try_to_free_pages(enum palloc_flags flags UNUSED)
+void __free_page(struct page* page, bool evicted)
 {
-    move_lru_clock();
-    struct page *pg = list_entry(lru_clock, struct page, lru);
-    while (pagedir_is_accessed(pg->thread->pagedir, pg->vme->vaddr) || pg->vme->pinned){
-        pagedir_set_accessed(pg->thread->pagedir, pg->vme->vaddr, false);
-        move_lru_clock();
-        pg = list_entry(lru_clock, struct page, lru);
-    }
-    struct page *target = pg;
-    switch(target->vme->type)
+    policy->remove(page, evicted);
+    page->vme->page = NULL;
+    pagedir_clear_page(page->thread->pagedir, pg_round_down(page->vme->vaddr));
+    release_frame(page);
+}
+
+/* Marks PAGE, returned by alloc_page(), as mapped into its
+   process, so that it may now be evicted. */
+void frame_installed(struct page *page)
+{
+    lock_acquire(&frame_lock);
+    ASSERT(page->state == FRAME_LOADING);
+    page->state = FRAME_MAPPED;
+    cond_broadcast(&page->transit, &frame_lock);
+    lock_release(&frame_lock);
+}
+
+/* Releases VME, which is about to be freed.  Frees its frame if
+   it has one, after waiting for any write to swap to finish, and
+   tells the replacement policy to forget it. */
+void frame_forget(struct vm_entry *vme)
+{
+    lock_acquire(&frame_lock);
+    while (vme->page != NULL && vme->page->state == FRAME_IN_TRANSIT)
+        cond_wait(&vme->page->transit, &frame_lock);
+    if (vme->page != NULL)
+        __free_page(vme->page, false);
+    policy->forget(vme);
+    lock_release(&frame_lock);
+}
+
+/* Pins VME's page, so that it will not be chosen for eviction,
+   and returns true if it is mapped.  Otherwise, the caller must
+   fault it in, after which the pin keeps it in its frame.  The
+   pin count is only changed under frame_lock, and a page is
+   only unmapped for eviction under frame_lock, so a page found
+   mapped here stays mapped.  Pins nest; each must be dropped
+   with frame_unpin(). */
+bool frame_pin(struct vm_entry *vme)
+{
+    bool mapped;
+
+    lock_acquire(&frame_lock);
+    vme->pin_cnt++;
+    mapped = vme->page != NULL && vme->page->state == FRAME_MAPPED;
+    lock_release(&frame_lock);
+    return mapped;
+}
+
+/* Drops a pin taken by frame_pin(), if VME has any.  Wakes up
+   the page-out daemon if frames are short, since it may have
+   given up because every page was pinned. */
+void frame_unpin(struct vm_entry *vme)
+{
+    lock_acquire(&frame_lock);
+    if (vme->pin_cnt > 0 && --vme->pin_cnt == 0 && free_cnt < free_low)
+        cond_signal(&pageout_wait, &frame_lock);
+    lock_release(&frame_lock);
+}
+
+/* Unmaps PAGE, which has been chosen for eviction, from its
+   vm_entry and tells the policy.  If the contents have to go to
+   swap, marks the frame in transit and returns true, leaving the
+   frame allocated and VME->page pointing to it until the write
+   is done.  Otherwise, detaches the frame from VME and returns
+   false. */
+static bool unmap_victim(struct page *page)
+{
+    struct vm_entry *vme = page->vme;
+    bool to_swap = false;
+
+    ASSERT(page->kaddr != NULL && page->state == FRAME_MAPPED);
+    switch(vme->type)
     {
         case VM_BIN:
-            if(pagedir_is_dirty(target->thread->pagedir, target->vme->vaddr))
+            if(pagedir_is_dirty(page->thread->pagedir, vme->vaddr))
             {
-                target->vme->swap_slot = swap_out(target->kaddr);
-                target->vme->type = VM_ANON;
+                vme->type = VM_ANON;
+                to_swap = true;
             }
             break;
         case VM_FILE:
             break;
         case VM_ANON:
-            target->vme->swap_slot = swap_out(target->kaddr);
+            to_swap = true;
             break;
     }
-    target->vme->is_loaded = false;
-    __free_page(target);
-}
\ No newline at end of file
+    /* Residency, as the policy sees it, ends here. */
+    if (to_swap)
+        page->state = FRAME_IN_TRANSIT;
+    else
+        vme->page = NULL;
+    policy->remove(page, true);
+    vme->is_loaded = false;
+    pagedir_clear_page(page->thread->pagedir, pg_round_down(vme->vaddr));
+    stats.evict_cnt++;
+    return to_swap;
+}
+
+/* Evicts up to SWAP_BATCH pages and writes the ones that need
+   it to swap together, so that they end up in adjacent slots and
+   go to the disk as one request.  Must be called with frame_lock
+   held.  The victims are claimed and unmapped under the lock,
+   which is then released for the write, so that other threads
+   can allocate and free frames meanwhile.  A fault on a page in
+   transit waits on its frame.  Returns the number of frames
+   freed, which is 0 only if no page could be evicted. */
+size_t try_to_free_pages(enum palloc_flags flags UNUSED)
+{
+    struct page *swapped[SWAP_BATCH];
+    void *kaddrs[SWAP_BATCH];
+    size_t slots[SWAP_BATCH];
+    size_t victim_cnt, swap_cnt = 0;
+    size_t i;
+
+    ASSERT(lock_held_by_current_thread(&frame_lock));
+
+    for (victim_cnt = 0; victim_cnt < SWAP_BATCH; victim_cnt++)
+    {
+        struct page *target = policy->victim();
+
+        if (target == NULL)
+            break;
+        if (unmap_victim(target))
+        {
+            swapped[swap_cnt] = target;
+            kaddrs[swap_cnt++] = target->kaddr;
+        }
+        else
+            release_frame(target);
+    }
+    if (swap_cnt == 0)
+        return victim_cnt;
+
+    lock_release(&frame_lock);
+    if (!swap_out_pages(kaddrs, swap_cnt, slots))
+        PANIC("out of swap space");
+    lock_acquire(&frame_lock);
+
+    for (i = 0; i < swap_cnt; i++)
+    {
+        struct page *pg = swapped[i];
+
+        pg->vme->swap_slot = slots[i];
+        pg->vme->page = NULL;
+        release_frame(pg);
+    }
+    stats.swap_out_cnt += swap_cnt;
+    return victim_cnt;
+}
+
+/* Returns true if PAGE has been accessed since the last call,
+   and clears its accessed bit. */
+bool frame_referenced(struct page *page)
+{
+    uint32_t *pd = page->thread->pagedir;
+    void *upage = page->vme->vaddr;
+
+    if (!pagedir_is_accessed(pd, upage))
+        return false;
+    pagedir_set_accessed(pd, upage, false);
+    return true;
+}
+
+/* Returns true if PAGE holds a mapped page that is not pinned,
+   so that it may be evicted. */
+bool frame_evictable(const struct page *page)
+{
+    return page->kaddr != NULL && page->state == FRAME_MAPPED
+           && page->vme->pin_cnt == 0;
+}
+
+/* Returns true if VME's page is in a frame and is not on its way
+   out to swap. */
+bool frame_resident(const struct vm_entry *vme)
+{
+    return vme->page != NULL && vme->page->state != FRAME_IN_TRANSIT;
+}
+
+/* Stores a copy of the virtual memory statistics in *ST. */
+void frame_get_stats(struct vmstat *st)
+{
+    lock_acquire(&frame_lock);
+    *st = stats;
+    lock_release(&frame_lock);
+    strlcpy(st->policy, policy->name, sizeof st->policy);
+    st->frame_cnt = frame_cnt;
+}
+
+/* Prints virtual memory statistics. */
+void frame_print_stats(void)
+{
+    printf("Frames: %s policy, %"PRIu32" faults, %"PRIu32" evictions, "
+           "%"PRIu32" swapped out, %"PRIu32" stalls (%"PRIu32" ticks)\n",
+           policy->name, stats.fault_cnt, stats.evict_cnt,
+           stats.swap_out_cnt, stats.stall_cnt, stats.stall_ticks);
+}
+
+static void clock_init(size_t cnt UNUSED)
+{
+    clock_hand = 0;
+}
+
+static void clock_insert(struct page *page UNUSED)
+{
+}
+
+static void clock_remove(struct page *page UNUSED, bool evicted UNUSED)
+{
+}
+
+/* Advances the clock hand and returns the frame it was on. */
+static struct page* next_frame(void)
+{
+    struct page *pg = &frames[clock_hand];
+    if (++clock_hand >= frame_cnt)
+        clock_hand = 0;
+    return pg;
+}
+
+/* Gives up after two turns of the clock, by which time every
+   accessed bit has been cleared, so that no frame can be
+   evicted. */
+static struct page* clock_victim(void)
+{
+    size_t i;
+
+    for (i = 0; i < 2 * frame_cnt; i++){
+        struct page *pg = next_frame();
+        if (frame_evictable(pg) && !frame_referenced(pg))
+            return pg;
+    }
+    return NULL;
+}
+
+static void clock_forget(struct vm_entry *vme UNUSED)
+{
+}
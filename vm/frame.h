@@ -3,22 +3,62 @@
 
 #include <hash.h>
 #include <list.h>
+#include <vmstat.h>
 #include "vm/page.h"
 #include "vm/swap.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 
-struct list lru_list;
-struct lock lru_list_lock;
-struct list_elem *lru_clock;
+extern struct lock frame_lock;
 
-void lru_list_init(void);
-void add_page_to_lru_list(struct page*);
-void del_page_from_lru_list(struct page*);
+/* A page replacement policy.  The frame table tells the policy
+   when a page enters a frame and when it leaves one, and asks it
+   to choose a victim when the user pool runs out.  A policy may
+   remember pages that have been evicted, through their
+   vm_entries' policy members, until it is told to forget them.
+   All of these functions are called with frame_lock held. */
+struct frame_policy
+  {
+    const char *name;
 
-struct page* alloc_page(enum palloc_flags);
+    /* Sets up the policy for FRAME_CNT frames. */
+    void (*init) (size_t frame_cnt);
+
+    /* PAGE has just been allocated to PAGE->vme. */
+    void (*insert) (struct page *page);
+
+    /* PAGE is being freed, because it was evicted if EVICTED is
+       true or because its vm_entry is going away otherwise. */
+    void (*remove) (struct page *page, bool evicted);
+
+    /* Returns a page to evict, one for which frame_evictable()
+       is true, or a null pointer if there is none. */
+    struct page *(*victim) (void);
+
+    /* VME, which is not in a frame, is about to be freed. */
+    void (*forget) (struct vm_entry *vme);
+  };
+
+extern const struct frame_policy clockpro_policy;
+extern const struct frame_policy arc_policy;
+
+bool frame_set_policy(const char *name);
+void frame_table_init(void);
+void frame_start_pageout(void);
+
+struct page* alloc_page(enum palloc_flags, struct vm_entry *);
 void free_page(void*);
-void __free_page(struct page*);
+void __free_page(struct page*, bool evicted);
+void frame_installed(struct page *);
+void frame_forget(struct vm_entry *);
+bool frame_pin(struct vm_entry *);
+void frame_unpin(struct vm_entry *);
+
+size_t try_to_free_pages(enum palloc_flags);
 
-void try_to_free_pages(enum palloc_flags);
-#endif
\ No newline at end of file
+bool frame_referenced(struct page *);
+bool frame_evictable(const struct page *);
+bool frame_resident(const struct vm_entry *);
+void frame_get_stats(struct vmstat *);
+void frame_print_stats(void);
+#endif
@@ -22,10 +22,21 @@ static bool vm_less_func (const struct hash_elem *a_, const struct hash_elem *b_
     return a->vaddr < b->vaddr;
 }
 
+/* Frees the swap slot holding VME's page, if it is in swap. */
+static void release_swap (struct vm_entry *vme)
+{
+    if (!vme->is_loaded && vme->type == VM_ANON
+        && vme->swap_slot != SWAP_SLOT_NONE){
+        swap_free(vme->swap_slot);
+        vme->swap_slot = SWAP_SLOT_NONE;
+    }
+}
+
 static void vm_destroy_func (struct hash_elem *e, void *aux UNUSED)
 {
 	struct vm_entry *vme = hash_entry(e, struct vm_entry, elem);
-    free_page(pagedir_get_page(thread_current()->pagedir, vme->vaddr));
+    frame_forget(vme);
+    release_swap(vme);
 	free(vme);
 }
 
@@ -34,16 +45,38 @@ void vm_init (struct hash *vm)
     hash_init(vm, vm_hash_func, vm_less_func, NULL);
 }
 
+/* Acquires the current process's supplemental page table lock.
+   Hold it from looking up a vm_entry until done acting on it,
+   so that the process's threads cannot change the table in
+   between. */
+void vm_lock_acquire (void)
+{
+    lock_acquire(&thread_current()->leader->vm_lock);
+}
+
+void vm_lock_release (void)
+{
+    lock_release(&thread_current()->leader->vm_lock);
+}
+
+static bool vm_lock_held (void)
+{
+    return lock_held_by_current_thread(&thread_current()->leader->vm_lock);
+}
+
 bool insert_vme (struct hash *vm, struct vm_entry *vme)
 {
+    ASSERT(vm_lock_held());
     return (hash_insert(vm, &vme->elem) == NULL);
 }
 
 bool delete_vme (struct hash *vm, struct vm_entry *vme)
 {
+    ASSERT(vm_lock_held());
     struct hash_elem *elem = hash_delete(vm, &vme->elem);
     if (elem != NULL){
-        free_page(pagedir_get_page(thread_current()->pagedir, vme->vaddr));
+        frame_forget(vme);
+        release_swap(vme);
         free(vme);
         return true;
     }
@@ -54,8 +87,9 @@ struct vm_entry *find_vme (void *vaddr)
 {
     struct vm_entry f;
 
+    ASSERT(vm_lock_held());
     f.vaddr = pg_round_down(vaddr);
-    struct hash_elem *e = hash_find(&thread_current()->vm, &f.elem);
+    struct hash_elem *e = hash_find(&thread_current()->leader->vm, &f.elem);
 
     return (e != NULL) ? hash_entry(e, struct vm_entry, elem) : NULL;
 }
@@ -73,22 +107,54 @@ bool load_file(void *kaddr, struct vm_entry *vme)
 	return true;
 }
 
-void pin_vme (void *front, int size)
+/* Pins each page of the SIZE-byte user buffer at FRONT, faulting
+   in the ones that are not loaded.  Pins nest: a page stays
+   pinned until each pin_vme() of it has been matched by an
+   unpin_vme(), so threads doing I/O to the same page do not
+   unpin it under each other.  The buffer must already have been
+   checked, but another thread of the process may have unmapped
+   part of it since; if a page is gone or cannot be loaded,
+   drops the pins taken so far and returns false. */
+bool pin_vme (void *front, int size)
 {
-	for(void *addr = front; addr < front + size; addr += PGSIZE)
+	void *addr;
+
+	if (!is_user_range(front, size))
+		return false;
+	vm_lock_acquire();
+	for(addr = front; addr < front + size; addr = pg_round_down(addr) + PGSIZE)
 	{
 		struct vm_entry *vme = find_vme(addr);
-		vme->pinned = true;
-		if(!vme->is_loaded)
-			handle_mm_fault(vme);
+		if (vme == NULL)
+			break;
+		if(!frame_pin(vme) && !handle_mm_fault(vme))
+		{
+			frame_unpin(vme);
+			break;
+		}
+	}
+	vm_lock_release();
+	if (addr < front + size)
+	{
+		unpin_vme(front, addr - front);
+		return false;
 	}
+	return true;
 }
 
+/* Drops a pin from each page of the SIZE-byte user buffer at
+   FRONT.  Skips pages that another thread has unmapped since
+   they were pinned. */
 void unpin_vme (void *front, int size)
 {
-	for(void *addr = front; addr < front + size; addr += PGSIZE)
+	if (!is_user_range(front, size))
+		return;
+	vm_lock_acquire();
+	for(void *addr = front; addr < front + size; addr = pg_round_down(addr) + PGSIZE)
 	{
 		struct vm_entry *vme = find_vme(addr);
-		vme->pinned = false;
+		if (vme != NULL)
+			frame_unpin(vme);
 	}
+	vm_lock_release();
 }
\ No newline at end of file
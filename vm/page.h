@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "filesys/file.h"
+#include "threads/synch.h"
 #include "threads/thread.h"
 
 #define VM_BIN 0
@@ -16,7 +17,6 @@
 struct vm_entry{
     uint8_t type;
     void *vaddr;
-    bool pinned;
     bool writable;
     bool is_loaded;
     uint32_t offset;
@@ -27,23 +27,42 @@ struct vm_entry{
     uint32_t swap_slot;
 
     struct hash_elem elem;
+
+    /* Owned by vm/frame.c and the replacement policies.  A newly
+       allocated vm_entry must have these zeroed. */
+    struct page *page;              /* Frame holding page, or null. */
+    struct list_elem policy_elem;   /* Replacement policy's list element. */
+    uint8_t policy_list;            /* Replacement policy's list, or 0. */
+    uint8_t policy_flags;           /* Replacement policy's flags. */
+    int pin_cnt;                    /* Pins taken by frame_pin(). */
 };
 
+/* Frame states. */
+#define FRAME_LOADING 0         /* Being filled in, not yet mapped. */
+#define FRAME_MAPPED 1          /* Mapped, may be evicted unless pinned. */
+#define FRAME_IN_TRANSIT 2      /* Evicted, being written to swap. */
+
+/* Frame descriptor.  There is one for each page in the user
+   pool, in the frame table in vm/frame.c. */
 struct page {
-    void *kaddr;
-    struct list_elem lru;
+    void *kaddr;                /* Kernel address, or null if free. */
     struct vm_entry *vme;
     struct thread *thread;
+    uint8_t state;              /* FRAME_*, if not free. */
+    struct condition transit;   /* Signaled when loading or write-back
+                                   is done. */
 };
 
 void vm_init(struct hash *);
+void vm_lock_acquire(void);
+void vm_lock_release(void);
 bool insert_vme(struct hash *, struct vm_entry *);
 bool delete_vme(struct hash *, struct vm_entry *);
 struct vm_entry *find_vme(void *);
 void vm_destroy(struct hash *);
 bool load_file(void *, struct vm_entry *);
 
-void pin_vme (void *, int);
+bool pin_vme (void *, int);
 void unpin_vme (void *, int);
 
 #endif
\ No newline at end of file
@@ -1,38 +1,144 @@
 #include "vm/swap.h"
-#include "vm/frame.h"
-#include "vm/page.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <string.h>
+#include "devices/block.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/vaddr.h"
 
-#define BLOCK_PAGE PGSIZE / BLOCK_SECTOR_SIZE     // page에 사용되는 블럭 수
+#define BLOCK_PAGE (PGSIZE / BLOCK_SECTOR_SIZE)     // page에 사용되는 블럭 수
+
+/* Swap device and its slot map, one bit per page-sized slot.
+   The map is sized from the device, and is empty if there is no
+   swap device. */
+static struct block *swap_block;
+static struct bitmap *swap_bitmap;
+static struct lock swap_lock;
+
+/* Slot after the last cluster allocated.  Allocation is next-fit
+   from here, so that pages evicted together land next to each
+   other and the slot map is not rescanned from the start every
+   time. */
+static size_t swap_cursor;
+
+/* Pages of a batch are copied here so that they can go to the
+   disk as one request. */
+static uint8_t *swap_buffer;
 
 void swap_init(void)
 {
-    swap_bitmap = bitmap_create(8*1024);
+    size_t slot_cnt = 0;
+
+    swap_block = block_get_role(BLOCK_SWAP);
+    if (swap_block != NULL)
+        slot_cnt = block_size(swap_block) / BLOCK_PAGE;
+    swap_bitmap = bitmap_create(slot_cnt);
+    if (swap_bitmap == NULL)
+        PANIC("swap slot map creation failed");
+    lock_init(&swap_lock);
+    swap_cursor = 0;
+    swap_buffer = palloc_get_multiple(PAL_ASSERT, SWAP_BATCH);
+}
+
+/* Returns the first sector of SLOT. */
+static block_sector_t slot_sector(size_t slot)
+{
+    return slot * BLOCK_PAGE;
 }
 
+/* Allocates CNT consecutive slots and returns the first one, or
+   BITMAP_ERROR if there is no such cluster.  Must be called with
+   swap_lock held. */
+static size_t alloc_cluster(size_t cnt)
+{
+    size_t slot = bitmap_scan_and_flip(swap_bitmap, swap_cursor, cnt, false);
+
+    if (slot == BITMAP_ERROR && swap_cursor != 0)
+        slot = bitmap_scan_and_flip(swap_bitmap, 0, cnt, false);
+    if (slot != BITMAP_ERROR)
+        swap_cursor = slot + cnt < bitmap_size(swap_bitmap) ? slot + cnt : 0;
+    return slot;
+}
+
+/* Reads the page in USED_INDEX into KADDR and frees the slot. */
 void swap_in(size_t used_index, void* kaddr)
 {
-    struct block *swap_block = block_get_role(BLOCK_SWAP);
-    if(bitmap_test(swap_bitmap, used_index))
-    {
-        for (int i = 0; i < BLOCK_PAGE; i++){
-            block_read(swap_block, (uint32_t)(used_index * BLOCK_PAGE + i), (void *)(kaddr + i * BLOCK_SECTOR_SIZE));
-        }
-        bitmap_reset(swap_bitmap, used_index);
-    }
+    ASSERT(used_index < bitmap_size(swap_bitmap));
+    ASSERT(bitmap_test(swap_bitmap, used_index));
+
+    block_read_multiple(swap_block, slot_sector(used_index), BLOCK_PAGE, kaddr);
+    swap_free(used_index);
 }
 
+/* Writes the page at KADDR to swap and returns its slot, or
+   BITMAP_ERROR if swap is full. */
 size_t swap_out(void* kaddr)
 {
-    struct block *swap_block = block_get_role(BLOCK_SWAP);
-    size_t first_fit = bitmap_scan(swap_bitmap, 0, 1, false);
+    size_t slot;
 
-    if (first_fit == BITMAP_ERROR)
+    if (!swap_out_pages(&kaddr, 1, &slot))
         return BITMAP_ERROR;
-    for (int i = 0; i < BLOCK_PAGE; i++){
-            block_write(swap_block, (uint32_t)(first_fit * BLOCK_PAGE + i), (void *)(kaddr + i * BLOCK_SECTOR_SIZE));
+    return slot;
+}
+
+/* Writes the CNT pages in PAGES, at most SWAP_BATCH, to swap and
+   stores the slot of PAGES[i] in SLOTS[i].  The pages go into
+   one cluster of slots with a single write if there is one free,
+   and one slot at a time otherwise.  Returns false, writing
+   nothing, if swap does not have CNT free slots. */
+bool swap_out_pages(void *const pages[], size_t cnt, size_t slots[])
+{
+    size_t first, i;
+
+    ASSERT(cnt <= SWAP_BATCH);
+
+    lock_acquire(&swap_lock);
+    first = alloc_cluster(cnt);
+    if (first != BITMAP_ERROR){
+        for (i = 0; i < cnt; i++)
+            slots[i] = first + i;
+        if (cnt == 1){
+            lock_release(&swap_lock);
+            block_write_multiple(swap_block, slot_sector(first), BLOCK_PAGE,
+                                 pages[0]);
+            return true;
+        }
+
+        /* The bounce buffer is shared, so keep swap_lock until the
+           write is done. */
+        for (i = 0; i < cnt; i++)
+            memcpy(swap_buffer + i * PGSIZE, pages[i], PGSIZE);
+        block_write_multiple(swap_block, slot_sector(first),
+                             cnt * BLOCK_PAGE, swap_buffer);
+        lock_release(&swap_lock);
+        return true;
+    }
+
+    for (i = 0; i < cnt; i++){
+        slots[i] = alloc_cluster(1);
+        if (slots[i] == BITMAP_ERROR){
+            while (i-- > 0)
+                bitmap_reset(swap_bitmap, slots[i]);
+            lock_release(&swap_lock);
+            return false;
         }
-        bitmap_set(swap_bitmap, first_fit, true);
+    }
+    lock_release(&swap_lock);
+
+    for (i = 0; i < cnt; i++)
+        block_write_multiple(swap_block, slot_sector(slots[i]), BLOCK_PAGE,
+                             pages[i]);
+    return true;
+}
 
-    return first_fit;
-}
\ No newline at end of file
+/* Frees SLOT, whose page is no longer needed. */
+void swap_free(size_t slot)
+{
+    ASSERT(slot < bitmap_size(swap_bitmap));
+
+    lock_acquire(&swap_lock);
+    ASSERT(bitmap_test(swap_bitmap, slot));
+    bitmap_reset(swap_bitmap, slot);
+    lock_release(&swap_lock);
+}
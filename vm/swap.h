@@ -1,17 +1,19 @@
 #ifndef VM_SWAP_H
 #define VM_SWAP_H
 
-#include <hash.h>
-#include <list.h>
-#include <bitmap.h>
+#include <stdbool.h>
 #include <stddef.h>
-#include <inttypes.h>
-#include "devices/block.h"
 
-struct bitmap *swap_bitmap;
+/* Most pages written to swap with one request. */
+#define SWAP_BATCH 8
+
+/* Swap slot of a page that is not in swap. */
+#define SWAP_SLOT_NONE ((size_t) -1)
 
 void swap_init(void);
 void swap_in(size_t, void*);
 size_t swap_out(void*);
+bool swap_out_pages(void *const pages[], size_t cnt, size_t slots[]);
+void swap_free(size_t);
 
-#endif
\ No newline at end of file
+#endif